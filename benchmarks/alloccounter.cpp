@@ -0,0 +1,92 @@
+#include "benchmark.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// 统计基准程序中的堆分配次数。
+// Qt容器经由 malloc 分配，glibc下通过同名符号插桩统计；其他平台只统计 operator new
+
+namespace {
+std::atomic<quint64> g_allocations{0};
+}
+
+namespace Bytedesk {
+
+quint64 allocationCount()
+{
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+} // namespace Bytedesk
+
+#if defined(__GLIBC__)
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+    __libc_free(ptr);
+}
+}
+
+// operator new 默认经由 malloc，已被上面统计
+
+#else
+
+void* operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+#endif
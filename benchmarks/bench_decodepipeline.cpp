@@ -0,0 +1,124 @@
+#include "benchmark.h"
+#include "core/mqtt/mqttdecodepipeline.h"
+#include "core/protobuf/protobufwrapper.h"
+#include "models/message.h"
+#include <QByteArray>
+#include <QList>
+#include <QThread>
+#include <cstdio>
+
+namespace Bytedesk {
+
+namespace {
+
+const int BACKLOG = 4096;   // 一轮提交的载荷数，模拟重连后broker补发的积压
+const int LANES = 64;       // 积压分布在多少个会话上
+
+struct BacklogPayload {
+    QString lane;
+    QString topic;
+    QByteArray data;
+};
+
+QList<BacklogPayload> buildBacklog()
+{
+    QList<BacklogPayload> backlog;
+    backlog.reserve(BACKLOG);
+    for (int i = 0; i < BACKLOG; ++i) {
+        const QString threadUid = QStringLiteral("thread_%1").arg(i % LANES);
+
+        Message message;
+        message.setUid(QStringLiteral("msg_%1").arg(i));
+        message.setType(MessageType::TEXT);
+        message.setStatus(MessageStatus::SENT);
+        message.setContent(QStringLiteral("你好，请问订单 %1 什么时候发货？").arg(i));
+        message.setCreatedAt(QDateTime::fromMSecsSinceEpoch(1700000000000LL + i));
+        message.setThreadUid(threadUid);
+        message.setUserUid(QStringLiteral("visitor_%1").arg(i % LANES));
+        message.setUserName(QStringLiteral("访客%1").arg(i % LANES));
+
+        backlog.append({threadUid, QStringLiteral("org/thread/") + threadUid, ProtobufWrapper::serializeMessage(message)});
+    }
+    return backlog;
+}
+
+// 与 MqttMessageHandler::decodePayload 相同的分支，无状态
+QList<MessagePtr> decodePayload(const QByteArray& payload, ProtobufDecoder& decoder)
+{
+    QList<MessagePtr> messages;
+    if (ProtobufWrapper::isMessageBatch(payload)) {
+        decoder.decodeBatch(payload, messages);
+        return messages;
+    }
+
+    MessagePtr message = MessagePtr::create();
+    if (decoder.decode(payload, *message)) {
+        messages.append(message);
+    }
+    return messages;
+}
+
+void benchmarkPipeline(const QList<BacklogPayload>& backlog, int parallelism)
+{
+    MqttDecodePipeline pipeline(parallelism, &decodePayload);
+    qint64 delivered = 0;
+    QObject::connect(&pipeline, &MqttDecodePipeline::decoded, [&](const QList<MqttDecodedPayload>& batch) {
+        for (const MqttDecodedPayload& payload : batch) {
+            delivered += payload.messages.size();
+        }
+    });
+
+    // 每轮提交整个积压，再等待全部按序交付
+    BenchmarkMeasurement measurement = measure(20, [&](qint64) {
+        for (const BacklogPayload& payload : backlog) {
+            pipeline.submit(payload.lane, payload.topic, MqttTopicRoute(), payload.data);
+        }
+        pipeline.drain();
+    });
+    measurement.iterations *= backlog.size();
+
+    const QByteArray name = QByteArray("pipeline, parallelism ") + QByteArray::number(parallelism);
+    printMeasurement(name.constData(), measurement);
+
+    const MqttDecodeStats stats = pipeline.getStats();
+    std::printf("  delivered %lld, batches %llu, max reorder depth %d, arena blocks/message %.4f\n",
+                static_cast<long long>(delivered), static_cast<unsigned long long>(stats.batches),
+                stats.maxReorderDepth, stats.decoder.blockAllocationsPerMessage());
+}
+
+} // namespace
+
+void benchmarkDecodePipeline()
+{
+    if (!ProtobufWrapper::isAvailable()) {
+        std::printf("  skipped: built without BYTEDESK_WITH_PROTOBUF\n");
+        return;
+    }
+
+    const QList<BacklogPayload> backlog = buildBacklog();
+
+    // 基线：同步路径，当前线程逐条解码，每64条回收一次Arena
+    ProtobufDecoder decoder;
+    BenchmarkMeasurement measurement = measure(20, [&](qint64) {
+        for (qsizetype i = 0; i < backlog.size(); ++i) {
+            doNotOptimize(decodePayload(backlog.at(i).data, decoder));
+            if (i % 64 == 63) {
+                decoder.reset();
+            }
+        }
+        decoder.reset();
+    });
+    measurement.iterations *= backlog.size();
+    printMeasurement("synchronous decode", measurement);
+
+    QList<int> parallelisms = {1, 2, 4};
+    const int ideal = QThread::idealThreadCount();
+    if (ideal > 4) {
+        parallelisms.append(ideal);
+    }
+    for (int parallelism : parallelisms) {
+        benchmarkPipeline(backlog, parallelism);
+    }
+}
+
+} // namespace Bytedesk
@@ -0,0 +1,107 @@
+#include "benchmark.h"
+#include "models/message.h"
+#include "models/thread.h"
+#include "models/user.h"
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+namespace Bytedesk {
+
+namespace {
+
+// 改造前的做法：函数内静态 QHash 查找，转字符串时由字面量构造 QString
+MessageType stringToTypeLegacy(const QString& typeStr)
+{
+    static QHash<QString, MessageType> typeMap = {
+        {"TEXT", MessageType::TEXT},
+        {"IMAGE", MessageType::IMAGE},
+        {"FILE", MessageType::FILE},
+        {"VIDEO", MessageType::VIDEO},
+        {"VOICE", MessageType::VOICE},
+        {"TYPING", MessageType::TYPING},
+        {"NOTICE", MessageType::NOTICE},
+        {"RECALL", MessageType::RECALL},
+        {"DELIVERED", MessageType::DELIVERED},
+        {"READ", MessageType::READ},
+        {"CUSTOM", MessageType::CUSTOM}
+    };
+    return typeMap.value(typeStr, MessageType::TEXT);
+}
+
+QString typeToStringLegacy(MessageType type)
+{
+    switch (type) {
+        case MessageType::TEXT: return "TEXT";
+        case MessageType::IMAGE: return "IMAGE";
+        case MessageType::FILE: return "FILE";
+        case MessageType::VIDEO: return "VIDEO";
+        case MessageType::VOICE: return "VOICE";
+        case MessageType::TYPING: return "TYPING";
+        case MessageType::NOTICE: return "NOTICE";
+        case MessageType::RECALL: return "RECALL";
+        case MessageType::DELIVERED: return "DELIVERED";
+        case MessageType::READ: return "READ";
+        case MessageType::CUSTOM: return "CUSTOM";
+        default: return "TEXT";
+    }
+}
+
+} // namespace
+
+void benchmarkEnumStrings()
+{
+    const qint64 iterations = 1000000;
+
+    // 入站常见分布：聊天消息为主，夹杂回执和输入状态，偶尔有未知类型
+    const QList<QString> names = {
+        QStringLiteral("TEXT"), QStringLiteral("TEXT"), QStringLiteral("IMAGE"), QStringLiteral("READ"),
+        QStringLiteral("DELIVERED"), QStringLiteral("TYPING"), QStringLiteral("TEXT"), QStringLiteral("UNKNOWN")
+    };
+    QList<QByteArray> utf8Names;
+    for (const QString& name : names) {
+        utf8Names.append(name.toUtf8());
+    }
+    const qsizetype mask = names.size() - 1;
+
+    printMeasurement("MessageType from QString, legacy QHash", measure(iterations, [&](qint64 i) {
+        doNotOptimize(stringToTypeLegacy(names.at(i & mask)));
+    }));
+    printMeasurement("Message::stringToType", measure(iterations, [&](qint64 i) {
+        doNotOptimize(Message::stringToType(names.at(i & mask)));
+    }));
+
+    // Protobuf/JSON解码路径拿到的是UTF-8字节
+    printMeasurement("MessageType from UTF-8, legacy fromUtf8 + QHash", measure(iterations, [&](qint64 i) {
+        doNotOptimize(stringToTypeLegacy(QString::fromUtf8(utf8Names.at(i & mask))));
+    }));
+    Message message;
+    printMeasurement("Message::setTypeUtf8", measure(iterations, [&](qint64 i) {
+        message.setTypeUtf8(utf8Names.at(i & mask));
+        doNotOptimize(message.getType());
+    }));
+
+    printMeasurement("MessageType to QString, legacy literal", measure(iterations, [&](qint64 i) {
+        doNotOptimize(typeToStringLegacy(static_cast<MessageType>(i % 11)));
+    }));
+    printMeasurement("Message::typeToString", measure(iterations, [&](qint64 i) {
+        doNotOptimize(Message::typeToString(static_cast<MessageType>(i % 11)));
+    }));
+    printMeasurement("Message::typeName", measure(iterations, [&](qint64 i) {
+        doNotOptimize(Message::typeName(static_cast<MessageType>(i % 11)));
+    }));
+
+    // 带 UNKNOWN 回退的表
+    const QList<QString> threadTypes = {
+        QStringLiteral("AGENT"), QStringLiteral("WORKGROUP"), QStringLiteral("ROBOT"), QStringLiteral("GROUP")
+    };
+    printMeasurement("Thread::stringToType", measure(iterations, [&](qint64 i) {
+        doNotOptimize(Thread::stringToType(threadTypes.at(i & 3)));
+    }));
+    printMeasurement("User::stringToStatus", measure(iterations, [&](qint64 i) {
+        doNotOptimize(User::stringToStatus(i & 1 ? QStringView(u"ONLINE") : QStringView(u"AWAY")));
+    }));
+}
+
+} // namespace Bytedesk
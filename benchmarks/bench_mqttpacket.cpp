@@ -0,0 +1,91 @@
+#include "benchmark.h"
+#include "core/mqtt/mqttpacket.h"
+#include <QByteArray>
+#include <QString>
+
+namespace Bytedesk {
+
+namespace {
+
+// 改造前的做法：每个字段单独 toUtf8()/append，长度只写一个字节
+QByteArray encodeStringLegacy(const QString& str)
+{
+    QByteArray result;
+    QByteArray utf8 = str.toUtf8();
+    result.append(static_cast<char>(utf8.length() >> 8));
+    result.append(static_cast<char>(utf8.length() & 0xFF));
+    result.append(utf8);
+    return result;
+}
+
+QByteArray buildPublishLegacy(const QString& topic, const QByteArray& payload, quint16 packetId)
+{
+    QByteArray packet;
+    packet.append(static_cast<char>(MqttProtocol::PUBLISH | 0x02));
+
+    QByteArray data;
+    data.append(encodeStringLegacy(topic));
+    data.append(static_cast<char>(packetId >> 8));
+    data.append(static_cast<char>(packetId & 0xFF));
+    data.append(payload);
+
+    packet.append(static_cast<char>(data.length() & 0xFF));
+    packet.append(data);
+    return packet;
+}
+
+QByteArray buildPublish(const QString& topic, const QByteArray& payload, quint16 packetId)
+{
+    const quint32 remainingLength = static_cast<quint32>(MqttPacketBuilder::stringSize(topic) + 2 + payload.size());
+    MqttPacketBuilder builder(MqttProtocol::PUBLISH | 0x02, remainingLength);
+    builder.writeString(topic);
+    builder.writeUint16(packetId);
+    builder.writeBytes(payload);
+    return builder.take();
+}
+
+void benchmarkPublish(const char* label, int payloadSize)
+{
+    const QString topic = QStringLiteral("org/thread/df_org_uid/1234567890/agent");
+    const QByteArray payload(payloadSize, 'x');
+    const qint64 iterations = 200000;
+
+    const QByteArray legacyName = QByteArray("publish legacy ") + label;
+    const QByteArray builderName = QByteArray("publish builder ") + label;
+
+    printMeasurement(legacyName.constData(), measure(iterations, [&](qint64 i) {
+        doNotOptimize(buildPublishLegacy(topic, payload, static_cast<quint16>(i)));
+    }));
+    printMeasurement(builderName.constData(), measure(iterations, [&](qint64 i) {
+        doNotOptimize(buildPublish(topic, payload, static_cast<quint16>(i)));
+    }));
+}
+
+} // namespace
+
+void benchmarkMqttPacket()
+{
+    benchmarkPublish("64B", 64);
+    benchmarkPublish("1KB", 1024);
+    benchmarkPublish("64KB", 64 * 1024);
+
+    // 入站方向：从流中解出报文（变长长度 + 零拷贝载荷切片）
+    QByteArray stream;
+    for (int i = 0; i < 1000; ++i) {
+        stream.append(buildPublish(QStringLiteral("org/thread/df_org_uid/1234567890/agent"),
+                                   QByteArray(256, 'x'), static_cast<quint16>(i + 1)));
+    }
+
+    printMeasurement("read 1000 x 256B publish", measure(2000, [&](qint64) {
+        MqttPacketReader reader;
+        reader.append(stream);
+        MqttPacket packet;
+        MqttPublishView publish;
+        while (reader.next(packet) == MqttPacketReader::Result::PACKET) {
+            MqttPacketReader::parsePublish(packet, publish);
+            doNotOptimize(publish.payload.size());
+        }
+    }));
+}
+
+} // namespace Bytedesk
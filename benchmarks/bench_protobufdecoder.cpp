@@ -0,0 +1,99 @@
+#include "benchmark.h"
+#include "core/protobuf/protobufwrapper.h"
+#include "models/message.h"
+#include <QByteArray>
+#include <QList>
+#include <cstdio>
+
+namespace Bytedesk {
+
+namespace {
+
+// 与线上文本消息相近的载荷：内容、会话、发送者头像都带上
+QByteArray sampleMessage(int index)
+{
+    Message message;
+    message.setUid(QStringLiteral("msg_%1").arg(index));
+    message.setType(MessageType::TEXT);
+    message.setStatus(MessageStatus::SENT);
+    message.setContent(QStringLiteral("你好，请问订单 %1 什么时候发货？").arg(index));
+    message.setCreatedAt(QDateTime::fromMSecsSinceEpoch(1700000000000LL + index));
+    message.setThreadUid(QStringLiteral("org/thread/df_org_uid/1234567890/agent"));
+    message.setUserUid(QStringLiteral("visitor_%1").arg(index % 16));
+    message.setUserName(QStringLiteral("访客%1").arg(index % 16));
+    message.setUserAvatar(QStringLiteral("https://cdn.weiyuai.cn/avatars/visitor.png"));
+    return ProtobufWrapper::serializeMessage(message);
+}
+
+// 按 batchSize 条一组解码，每组结束 reset() 一次，模拟一批 readyRead
+void benchmarkDecoderBatch(const QList<QByteArray>& payloads, int batchSize)
+{
+    ProtobufDecoder decoder;
+    const qint64 batches = payloads.size() / batchSize;
+
+    BenchmarkMeasurement measurement = measure(batches * 20, [&](qint64 i) {
+        const qsizetype first = (i % batches) * batchSize;
+        for (qsizetype j = first; j < first + batchSize; ++j) {
+            Message message;
+            decoder.decode(payloads.at(j), message);
+            doNotOptimize(message);
+        }
+        decoder.reset();
+    });
+    measurement.iterations *= batchSize;
+
+    const QByteArray name = QByteArray("ProtobufDecoder::decode, reset per ") + QByteArray::number(batchSize);
+    printMeasurement(name.constData(), measurement);
+    const ProtobufDecodeStats stats = decoder.getStats();
+    std::printf("  arena block allocations/message %.4f, max batch arena %llu bytes\n",
+                stats.blockAllocationsPerMessage(),
+                static_cast<unsigned long long>(stats.maxBatchArenaBytes));
+}
+
+} // namespace
+
+void benchmarkProtobufDecoder()
+{
+    if (!ProtobufWrapper::isAvailable()) {
+        std::printf("  skipped: built without BYTEDESK_WITH_PROTOBUF\n");
+        return;
+    }
+
+    QList<QByteArray> payloads;
+    for (int i = 0; i < 1024; ++i) {
+        payloads.append(sampleMessage(i));
+    }
+
+    // 基线：每条消息单独在堆上构造proto对象
+    printMeasurement("ProtobufWrapper::parseMessage", measure(200000, [&](qint64 i) {
+        Message message;
+        ProtobufWrapper::parseMessage(payloads.at(i % payloads.size()), message);
+        doNotOptimize(message);
+    }));
+
+    benchmarkDecoderBatch(payloads, 1);
+    benchmarkDecoderBatch(payloads, 64);
+    benchmarkDecoderBatch(payloads, 1024);
+
+    // MessageBatch 信封：一个载荷64条
+    QList<MessagePtr> messages;
+    for (int i = 0; i < 64; ++i) {
+        MessagePtr message = MessagePtr::create();
+        ProtobufWrapper::parseMessage(payloads.at(i), *message);
+        messages.append(message);
+    }
+    const QByteArray envelope = ProtobufWrapper::serializeMessageBatch(messages);
+
+    ProtobufDecoder decoder;
+    BenchmarkMeasurement measurement = measure(5000, [&](qint64) {
+        QList<MessagePtr> decoded;
+        decoder.decodeBatch(envelope, decoded);
+        doNotOptimize(decoded);
+        decoder.reset();
+    });
+    measurement.iterations *= messages.size();
+    printMeasurement("ProtobufDecoder::decodeBatch, 64 per envelope", measurement);
+    std::printf("  arena block allocations/message %.4f\n", decoder.getStats().blockAllocationsPerMessage());
+}
+
+} // namespace Bytedesk
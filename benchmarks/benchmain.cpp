@@ -0,0 +1,52 @@
+#include "benchmark.h"
+#include <QCoreApplication>
+#include <QStringList>
+#include <cstdio>
+
+namespace Bytedesk {
+
+void printHeader(const char* suite)
+{
+    std::printf("\n== %s\n%-52s %12s %12s\n", suite, "benchmark", "ns/op", "allocs/op");
+}
+
+void printMeasurement(const char* name, const BenchmarkMeasurement& measurement)
+{
+    std::printf("%-52s %12.1f %12.2f\n", name, measurement.nsPerOp(), measurement.allocationsPerOp());
+    std::fflush(stdout);
+}
+
+} // namespace Bytedesk
+
+using namespace Bytedesk;
+
+namespace {
+
+struct BenchmarkSuite {
+    const char* name;
+    void (*run)();
+};
+
+const BenchmarkSuite SUITES[] = {
+    {"mqttpacket", benchmarkMqttPacket},
+    {"protobufdecoder", benchmarkProtobufDecoder},
+    {"decodepipeline", benchmarkDecodePipeline},
+    {"enumstrings", benchmarkEnumStrings},
+};
+
+} // namespace
+
+// 用法：bytedesk-bench [组名...]，不带参数时运行全部
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList selected = app.arguments().mid(1);
+
+    for (const BenchmarkSuite& suite : SUITES) {
+        if (selected.isEmpty() || selected.contains(QLatin1String(suite.name))) {
+            printHeader(suite.name);
+            suite.run();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+namespace Bytedesk {
+
+// 进程内的堆分配次数（operator new，以及glibc下的 malloc/calloc/realloc）
+quint64 allocationCount();
+
+// 一次测量的结果
+struct BenchmarkMeasurement {
+    qint64 iterations = 0;
+    qint64 nsecs = 0;
+    quint64 allocations = 0;
+
+    double nsPerOp() const { return iterations > 0 ? double(nsecs) / double(iterations) : 0.0; }
+    double allocationsPerOp() const { return iterations > 0 ? double(allocations) / double(iterations) : 0.0; }
+};
+
+// 先预热一轮，再计时运行 fn(i) iterations 次
+template <typename Fn>
+BenchmarkMeasurement measure(qint64 iterations, Fn&& fn)
+{
+    for (qint64 i = 0; i < qMin<qint64>(iterations, 1000); ++i) {
+        fn(i);
+    }
+
+    BenchmarkMeasurement result;
+    result.iterations = iterations;
+    const quint64 allocationsBefore = allocationCount();
+    QElapsedTimer timer;
+    timer.start();
+    for (qint64 i = 0; i < iterations; ++i) {
+        fn(i);
+    }
+    result.nsecs = timer.nsecsElapsed();
+    result.allocations = allocationCount() - allocationsBefore;
+    return result;
+}
+
+// 打印一行：名称、每次耗时、每次分配次数
+void printMeasurement(const char* name, const BenchmarkMeasurement& measurement);
+void printHeader(const char* suite);
+
+// 防止被测结果被编译器优化掉
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// 各组基准
+void benchmarkMqttPacket();
+void benchmarkProtobufDecoder();
+void benchmarkDecodePipeline();
+void benchmarkEnumStrings();
+
+} // namespace Bytedesk
+
+#endif // BENCHMARK_H
@@ -15,6 +15,10 @@ CONFIG += c++17
 # 定义
 DEFINES += QT_DEPRECATED_WARNINGS
 
+# Protobuf支持：需要先用protoc生成 proto/*.pb.cc 并链接libprotobuf
+# DEFINES += BYTEDESK_WITH_PROTOBUF
+# LIBS += -lprotobuf
+
 # 源文件 - 只包含已实现的文件
 SOURCES += \
     src/main.cpp \
@@ -22,10 +26,20 @@ SOURCES += \
     src/models/message.cpp \
     src/models/thread.cpp \
     src/models/user.cpp \
+    src/models/uidgenerator.cpp \
     src/models/config.cpp \
     src/core/mqtt/mqttclient.cpp \
     src/core/mqtt/mqttmessagehandler.cpp \
+    src/core/mqtt/mqttpacket.cpp \
+    src/core/mqtt/mqtttopictrie.cpp \
+    src/core/mqtt/mqttmessagebridge.cpp \
+    src/core/mqtt/mqttsessionstore.cpp \
+    src/core/mqtt/mqttdedupcache.cpp \
+    src/core/mqtt/mqtttypingengine.cpp \
+    src/core/mqtt/mqttdecodepipeline.cpp \
+    src/core/protobuf/protobufwrapper.cpp \
     src/core/network/httpclient.cpp \
+    src/core/network/httpcache.cpp \
     src/core/network/apibase.cpp \
     src/core/network/authapi.cpp \
     src/core/network/messageapi.cpp \
@@ -38,10 +52,22 @@ HEADERS += \
     src/models/message.h \
     src/models/thread.h \
     src/models/user.h \
+    src/models/enumstrings.h \
+    src/models/uidgenerator.h \
     src/models/config.h \
     src/core/mqtt/mqttclient.h \
     src/core/mqtt/mqttmessagehandler.h \
+    src/core/mqtt/mqttpacket.h \
+    src/core/mqtt/mqtttopictrie.h \
+    src/core/mqtt/mqttmessagebridge.h \
+    src/core/mqtt/mqttsessionstore.h \
+    src/core/mqtt/mqttdedupcache.h \
+    src/core/mqtt/mqtttypingengine.h \
+    src/core/mqtt/mqttdecodepipeline.h \
+    src/core/protobuf/protobufwrapper.h \
+    src/core/mqtt/spscringbuffer.h \
     src/core/network/httpclient.h \
+    src/core/network/httpcache.h \
     src/core/network/apibase.h \
     src/core/network/authapi.h \
     src/core/network/messageapi.h \
@@ -250,8 +250,8 @@ void AuthManager::connectMqttWithToken()
     QString username = m_currentUser->getUsername();
     QString password = m_accessToken;
 
-    // 生成客户端ID
-    QString deviceUid = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    // 生成客户端ID：设备ID固定，重启后可以恢复持久会话
+    QString deviceUid = BYTDESK_CONFIG->getDeviceUid();
     QString clientId = BYTDESK_CONFIG->generateMqttClientId(m_userUid, deviceUid);
 
     m_mqttClient->connectToHost(mqttHost, mqttPort, username, password, clientId);
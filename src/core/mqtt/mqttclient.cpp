@@ -3,25 +3,13 @@
 #include <QJsonDocument>
 #include <QDebug>
 #include <QHostAddress>
+#include <QThread>
+#include <QRandomGenerator>
 #include <QtGlobal>
+#include <algorithm>
 
 namespace Bytedesk {
 
-// MQTT协议常量
-namespace MqttProtocol {
-    const quint8 CONNECT = 0x10;
-    const quint8 CONNACK = 0x20;
-    const quint8 PUBLISH = 0x30;
-    const quint8 PUBACK = 0x40;
-    const quint8 SUBSCRIBE = 0x82;
-    const quint8 SUBACK = 0x90;
-    const quint8 UNSUBSCRIBE = 0xA2;
-    const quint8 UNSUBACK = 0xB0;
-    const quint8 PINGREQ = 0xC0;
-    const quint8 PINGRESP = 0xD0;
-    const quint8 DISCONNECT = 0xE0;
-}
-
 MqttClient::MqttClient(QObject* parent)
     : QObject(parent)
     , m_socket(new QTcpSocket(this))
@@ -31,40 +19,112 @@ MqttClient::MqttClient(QObject* parent)
     , m_keepAliveTimer(new QTimer(this))
     , m_reconnectTimer(new QTimer(this))
     , m_connectTimeoutTimer(new QTimer(this))
+    , m_pingResponseTimer(new QTimer(this))
+    , m_lastInboundAt(0)
+    , m_lastOutboundAt(0)
+    , m_pingSentAt(0)
+    , m_pingTimeout(10000)
     , m_keepAliveInterval(30000)
     , m_reconnectInterval(3000)
+    , m_maxReconnectDelay(60000)
     , m_connectTimeout(30000)
-    , m_maxReconnectAttempts(5)
     , m_currentReconnectAttempt(0)
+    , m_disconnectedAt(-1)
     , m_manualDisconnect(false)
     , m_messageId(1)
+    , m_maxSubscribePacketSize(16 * 1024)
+    , m_subscriptionFlushScheduled(false)
+    , m_maxInflight(64)
+    , m_inflightSequence(0)
     , m_willQos(0)
+    , m_sessionSaveTimer(new QTimer(this))
+    , m_writeBufferPackets(0)
+    , m_writeFlushTimer(new QTimer(this))
+    , m_writeBudgetUs(0)
+    , m_maxWriteBufferBytes(64 * 1024)
 {
+    m_clock.start();
+
+    // 会话状态变化较频繁，合并后写盘
+    m_sessionSaveTimer->setSingleShot(true);
+    m_sessionSaveTimer->setInterval(500);
+    m_reconnectTimer->setSingleShot(true);
+    m_connectTimeoutTimer->setSingleShot(true);
+    m_keepAliveTimer->setSingleShot(true);
+    m_keepAliveTimer->setTimerType(Qt::CoarseTimer);
+    m_pingResponseTimer->setSingleShot(true);
+    m_writeFlushTimer->setSingleShot(true);
+    m_writeFlushTimer->setTimerType(Qt::PreciseTimer);
+
     connect(m_socket, &QTcpSocket::connected, this, &MqttClient::onConnected);
     connect(m_socket, &QTcpSocket::disconnected, this, &MqttClient::onDisconnected);
     connect(m_socket, &QTcpSocket::errorOccurred, this, &MqttClient::onError);
     connect(m_socket, &QTcpSocket::readyRead, this, &MqttClient::onReadyRead);
 
     connect(m_keepAliveTimer, &QTimer::timeout, this, &MqttClient::onKeepAliveTimeout);
+    connect(m_pingResponseTimer, &QTimer::timeout, this, &MqttClient::onPingResponseTimeout);
     connect(m_reconnectTimer, &QTimer::timeout, this, &MqttClient::reconnect);
     connect(m_connectTimeoutTimer, &QTimer::timeout, this, &MqttClient::onConnectTimeout);
+    connect(m_writeFlushTimer, &QTimer::timeout, this, &MqttClient::flushWrites);
+    connect(m_sessionSaveTimer, &QTimer::timeout, this, &MqttClient::saveSession);
+
+    // 网络恢复时立即重连，不必等待退避
+    if (QNetworkInformation::loadBackendByFeatures(QNetworkInformation::Feature::Reachability)) {
+        connect(QNetworkInformation::instance(), &QNetworkInformation::reachabilityChanged,
+                this, &MqttClient::onReachabilityChanged);
+    } else {
+        qDebug() << "MQTT network reachability backend not available";
+    }
 }
 
 MqttClient::~MqttClient()
 {
-    disconnectFromHost();
+    // 跨线程析构时socket会随子对象一起销毁，不再排队发送DISCONNECT
+    if (!isOtherThread()) {
+        disconnectFromHost();
+    }
 }
 
 void MqttClient::connectToHost(const QString& host, int port, const QString& username,
                               const QString& password, const QString& clientId)
 {
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() {
+            connectToHost(host, port, username, password, clientId);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    if (!MqttPacketBuilder::fitsString(clientId) || !MqttPacketBuilder::fitsString(username)
+        || !MqttPacketBuilder::fitsString(password)) {
+        const QString error = "MQTT client id, username or password exceeds 65535 bytes";
+        qWarning() << error;
+        emit errorOccurred(error);
+        return;
+    }
+
+    // 客户端ID变化意味着不再延续之前的会话，丢弃未确认的报文
+    if (!m_clientId.isEmpty() && m_clientId != clientId) {
+        dropInflight();
+    }
+
     m_host = host;
     m_port = port;
     m_username = username;
     m_password = password;
     m_clientId = clientId;
+
+    if (m_cleanSession) {
+        m_sessionStore.remove(clientId);
+        m_sessionClientId.clear();
+    } else if (m_sessionClientId != clientId) {
+        restoreSession();
+    }
+
     m_manualDisconnect = false;
     m_currentReconnectAttempt = 0;
+    m_disconnectedAt = -1;
+    m_reconnectTimer->stop();
 
     qDebug() << "MQTT connecting to:" << host << ":" << port << "as" << clientId;
 
@@ -76,17 +136,23 @@ void MqttClient::connectToHost(const QString& host, int port, const QString& use
 
 void MqttClient::disconnectFromHost()
 {
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, &MqttClient::disconnectFromHost, Qt::QueuedConnection);
+        return;
+    }
+
     m_manualDisconnect = true;
     m_reconnectTimer->stop();
     m_connectTimeoutTimer->stop();
     m_keepAliveTimer->stop();
+    m_pingResponseTimer->stop();
+    saveSession();
 
     if (m_socket->state() == QTcpSocket::ConnectedState) {
         // 发送DISCONNECT报文
-        QByteArray packet;
-        packet.append(static_cast<char>(MqttProtocol::DISCONNECT));
-        packet.append(static_cast<char>(0x00)); // Remaining length
-        m_socket->write(packet);
+        MqttPacketBuilder builder(MqttProtocol::DISCONNECT, 0);
+        writePacket(builder.take());
+        flushWrites();
 
         m_socket->disconnectFromHost();
     }
@@ -96,73 +162,182 @@ void MqttClient::disconnectFromHost()
 
 void MqttClient::reconnect()
 {
-    if (m_manualDisconnect) {
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, &MqttClient::reconnect, Qt::QueuedConnection);
         return;
     }
 
-    if (m_currentReconnectAttempt >= m_maxReconnectAttempts) {
-        QString error = QString("Max reconnect attempts (%1) reached").arg(m_maxReconnectAttempts);
-        qWarning() << "MQTT:" << error;
-        setState(MqttConnectionState::ERROR);
-        m_reconnectTimer->stop();
-        emit errorOccurred(error);
+    if (m_manualDisconnect || m_host.isEmpty()) {
         return;
     }
 
+    m_reconnectTimer->stop();
     m_currentReconnectAttempt++;
-    qDebug() << "MQTT reconnect attempt" << m_currentReconnectAttempt << "of" << m_maxReconnectAttempts;
+    m_reconnectStats.attempts++;
+    if (m_disconnectedAt < 0) {
+        m_disconnectedAt = m_clock.elapsed();
+    }
+    qDebug() << "MQTT reconnect attempt" << m_currentReconnectAttempt;
 
-    disconnectFromHost();
-    m_manualDisconnect = false;
+    // 丢弃残留的连接（不经过 disconnectFromHost，避免被当作主动断开）
+    if (m_socket->state() != QAbstractSocket::UnconnectedState) {
+        m_socket->abort();
+        m_reconnectTimer->stop(); // abort 触发的 onDisconnected 会重新排期
+    }
 
-    QTimer::singleShot(m_reconnectInterval, this, [this]() {
-        setState(MqttConnectionState::RECONNECTING);
-        m_socket->connectToHost(m_host, m_port);
-    });
+    setState(MqttConnectionState::RECONNECTING);
+    m_connectTimeoutTimer->start(m_connectTimeout);
+    m_socket->connectToHost(m_host, m_port);
 }
 
 bool MqttClient::isConnected() const
 {
-    return m_state == MqttConnectionState::CONNECTED;
+    return m_state.load() == MqttConnectionState::CONNECTED;
+}
+
+bool MqttClient::isOtherThread() const
+{
+    return QThread::currentThread() != thread();
 }
 
 void MqttClient::subscribe(const QString& topic, quint8 qos)
 {
-    if (!isConnected()) {
-        qWarning() << "Cannot subscribe, not connected:" << topic;
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { subscribe(topic, qos); }, Qt::QueuedConnection);
         return;
     }
 
+    if (!MqttPacketBuilder::fitsString(topic)) {
+        qWarning() << "MQTT topic filter exceeds 65535 bytes, not subscribed:" << topic.left(64);
+        emit subscriptionFailed(topic);
+        return;
+    }
+
+    auto it = m_subscriptions.constFind(topic);
+    if (it != m_subscriptions.constEnd() && it.value() == qos) {
+        return; // 已订阅，避免重复发送
+    }
+
     m_subscriptions[topic] = qos;
-    sendMqttSubscribe(topic, qos);
+    m_pendingUnsubscribes.remove(topic);
+    // 未连接时也记录下来：恢复持久会话时只需发送离线期间的增量
+    m_pendingSubscribes.insert(topic);
+
+    if (isConnected()) {
+        scheduleSubscriptionFlush();
+    }
+    markSessionDirty();
     qDebug() << "Subscribed to topic:" << topic;
 }
 
 void MqttClient::unsubscribe(const QString& topic)
 {
-    if (m_subscriptions.contains(topic)) {
-        m_subscriptions.remove(topic);
-        // TODO: 实现UNSUBSCRIBE报文
-        qDebug() << "Unsubscribed from topic:" << topic;
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { unsubscribe(topic); }, Qt::QueuedConnection);
+        return;
+    }
+
+    if (m_subscriptions.remove(topic) == 0) {
+        return;
     }
+
+    m_pendingSubscribes.remove(topic);
+    m_pendingUnsubscribes.insert(topic);
+
+    if (isConnected()) {
+        scheduleSubscriptionFlush();
+    }
+    markSessionDirty();
+    qDebug() << "Unsubscribed from topic:" << topic;
 }
 
 void MqttClient::unsubscribeAll()
 {
-    for (const QString& topic : m_subscriptions.keys()) {
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, &MqttClient::unsubscribeAll, Qt::QueuedConnection);
+        return;
+    }
+
+    const QStringList topics = m_subscriptions.keys();
+    for (const QString& topic : topics) {
         unsubscribe(topic);
     }
 }
 
-void MqttClient::publish(const QString& topic, const QByteArray& payload, quint8 qos, bool retain)
+void MqttClient::setMaxSubscribePacketSize(int bytes)
 {
+    m_maxSubscribePacketSize = qMax(64, bytes);
+}
+
+quint16 MqttClient::publish(const QString& topic, const QByteArray& payload, quint8 qos, bool retain)
+{
+    Q_ASSERT_X(!isOtherThread(), "MqttClient::publish", "must be called from the client's thread");
+
     if (!isConnected()) {
         qWarning() << "Cannot publish, not connected:" << topic;
-        return;
+        return 0;
+    }
+
+    if (!MqttPacketBuilder::fitsString(topic)) {
+        qWarning() << "MQTT topic exceeds 65535 bytes, not published:" << topic.left(64);
+        return 0;
     }
 
-    sendMqttPublish(topic, payload, qos, retain);
-    qDebug() << "Published message to:" << topic << "QoS:" << qos;
+    if (qos == 0) {
+        QByteArray packet = buildPublishPacket(topic, payload, 0, retain, 0);
+        if (!packet.isEmpty()) {
+            writePacket(packet);
+            qDebug() << "Published message to:" << topic << "QoS:" << qos;
+        }
+        return 0;
+    }
+
+    qos = qMin<quint8>(qos, 2);
+
+    // 排队数量有上限：每个排队报文都预先占用一个报文ID
+    if (m_pendingPublishes.size() >= MAX_PENDING_PUBLISHES) {
+        qWarning() << "MQTT publish queue full, dropped:" << topic << "queued:" << m_pendingPublishes.size();
+        return 0;
+    }
+
+    const quint16 packetId = calculateMessageId();
+    if (packetId == 0) {
+        qWarning() << "MQTT no free packet id, dropped:" << topic;
+        return 0;
+    }
+
+    // 窗口已满时排队，收到确认后再依次发出
+    if (m_inflight.size() >= m_maxInflight) {
+        m_pendingPublishes.enqueue({packetId, topic, payload, qos, retain});
+        m_pendingPacketIds.insert(packetId);
+        markSessionDirty();
+        qDebug() << "MQTT inflight window full, queued packet:" << packetId;
+        return packetId;
+    }
+
+    sendInflightPublish(packetId, topic, payload, qos, retain);
+    qDebug() << "Published message to:" << topic << "QoS:" << qos << "packet:" << packetId;
+    return packetId;
+}
+
+void MqttClient::setMaxInflight(int maxInflight)
+{
+    m_maxInflight = qMax(1, maxInflight);
+    drainPendingPublishes();
+}
+
+MqttInflightStats MqttClient::getInflightStats() const
+{
+    MqttInflightStats stats = m_inflightStats;
+    stats.inflight = m_inflight.size();
+    stats.queued = m_pendingPublishes.size();
+    return stats;
+}
+
+void MqttClient::setWriteCoalescing(int budgetUs, int maxBytes)
+{
+    m_writeBudgetUs = qMax(0, budgetUs);
+    m_maxWriteBufferBytes = qMax(1, maxBytes);
 }
 
 void MqttClient::setMessageCallback(MqttMessageCallback callback)
@@ -188,16 +363,23 @@ void MqttClient::setErrorCallback(MqttErrorCallback callback)
 void MqttClient::startKeepAlive(int intervalMs)
 {
     m_keepAliveInterval = intervalMs;
-    m_keepAliveTimer->start(intervalMs);
-    qDebug() << "Keep alive timer started, interval:" << intervalMs << "ms";
+    m_pingResponseTimer->stop();
+    scheduleKeepAlive();
+    qDebug() << "Keep alive started, interval:" << intervalMs << "ms";
 }
 
 void MqttClient::stopKeepAlive()
 {
     m_keepAliveTimer->stop();
+    m_pingResponseTimer->stop();
     qDebug() << "Keep alive timer stopped";
 }
 
+void MqttClient::setPingTimeout(int milliseconds)
+{
+    m_pingTimeout = qMax(1, milliseconds);
+}
+
 void MqttClient::setKeepAlive(int seconds)
 {
     m_keepAliveInterval = seconds * 1000;
@@ -205,7 +387,12 @@ void MqttClient::setKeepAlive(int seconds)
 
 void MqttClient::setReconnectInterval(int milliseconds)
 {
-    m_reconnectInterval = milliseconds;
+    m_reconnectInterval = qMax(1, milliseconds);
+}
+
+void MqttClient::setMaxReconnectDelay(int milliseconds)
+{
+    m_maxReconnectDelay = qMax(1, milliseconds);
 }
 
 void MqttClient::setConnectTimeout(int milliseconds)
@@ -218,6 +405,11 @@ void MqttClient::setCleanSession(bool clean)
     m_cleanSession = clean;
 }
 
+void MqttClient::setSessionStoreDirectory(const QString& directory)
+{
+    m_sessionStore = MqttSessionStore(directory);
+}
+
 void MqttClient::setWillMessage(const QString& topic, const QByteArray& message, quint8 qos)
 {
     m_willTopic = topic;
@@ -227,134 +419,594 @@ void MqttClient::setWillMessage(const QString& topic, const QByteArray& message,
 
 void MqttClient::setState(MqttConnectionState state)
 {
-    if (m_state != state) {
-        m_state = state;
+    if (m_state.exchange(state) != state) {
         emit connectionStateChanged(state);
     }
 }
 
 void MqttClient::scheduleReconnect()
 {
-    if (!m_manualDisconnect && m_maxReconnectAttempts > 0) {
-        m_reconnectTimer->start(m_reconnectInterval);
+    // 本次连接尝试已结束，超时计时由下一次尝试重新开始
+    m_connectTimeoutTimer->stop();
+
+    // 错误和断开信号可能先后到达，已排期时不重复排期
+    if (m_manualDisconnect || m_host.isEmpty() || m_reconnectTimer->isActive()) {
+        return;
+    }
+
+    if (m_disconnectedAt < 0) {
+        m_disconnectedAt = m_clock.elapsed();
+    }
+
+    const int delay = nextReconnectDelay();
+    setState(MqttConnectionState::RECONNECTING);
+    m_reconnectTimer->start(delay);
+    qDebug() << "MQTT reconnect scheduled in" << delay << "ms, attempt" << m_currentReconnectAttempt + 1;
+}
+
+int MqttClient::nextReconnectDelay() const
+{
+    // 第一次立即重试
+    if (m_currentReconnectAttempt == 0) {
+        return 0;
     }
+
+    // 指数退避 + 全抖动：在 [0, min(上限, 基数 * 2^(n-1))] 内均匀随机，
+    // 避免broker重启后大量客户端同时重连
+    const int exponent = qMin(m_currentReconnectAttempt - 1, 20);
+    const qint64 ceiling = qMin<qint64>(m_maxReconnectDelay,
+                                        static_cast<qint64>(m_reconnectInterval) << exponent);
+    return static_cast<int>(QRandomGenerator::global()->bounded(ceiling + 1));
 }
 
 void MqttClient::updateLastMessageTime()
 {
-    m_lastMessageTime = QDateTime::currentDateTime();
+    m_lastInboundAt = m_clock.elapsed();
+}
+
+void MqttClient::scheduleKeepAlive()
+{
+    if (m_keepAliveInterval <= 0 || !isConnected()) {
+        return;
+    }
+
+    // 在较早空闲的方向满一个周期时唤醒；期间的流量不会重启定时器，
+    // 到期时再判断是否真的需要探测
+    const qint64 due = qMin(m_lastInboundAt, m_lastOutboundAt) + m_keepAliveInterval;
+    m_keepAliveTimer->start(static_cast<int>(qMax<qint64>(0, due - m_clock.elapsed())));
 }
 
 void MqttClient::sendMqttConnect()
 {
-    // 构建CONNECT报文
-    QByteArray packet;
-    packet.append(static_cast<char>(MqttProtocol::CONNECT));
+    // 构建CONNECT报文：协议名(6) + 协议级别(1) + 连接标志(1) + 心跳(2) + 载荷
+    quint32 remainingLength = 10 + MqttPacketBuilder::stringSize(m_clientId);
+    if (!m_username.isEmpty()) {
+        remainingLength += MqttPacketBuilder::stringSize(m_username);
+    }
+    if (!m_password.isEmpty()) {
+        remainingLength += MqttPacketBuilder::stringSize(m_password);
+    }
 
-    QByteArray payload;
+    MqttPacketBuilder builder(MqttProtocol::CONNECT, remainingLength);
     // Protocol name
-    payload.append(static_cast<char>(0x00));
-    payload.append(static_cast<char>(0x04)); // Length
-    payload.append('M'); payload.append('Q'); payload.append('T'); payload.append('T');
+    builder.writeString(u"MQTT");
     // Protocol level
-    payload.append(static_cast<char>(0x04)); // MQTT 3.1.1
+    builder.writeByte(0x04); // MQTT 3.1.1
     // Connect flags
     quint8 flags = 0x00;
     if (m_cleanSession) flags |= 0x02;
     if (!m_username.isEmpty()) flags |= 0x80;
     if (!m_password.isEmpty()) flags |= 0x40;
-    payload.append(static_cast<char>(flags));
+    builder.writeByte(flags);
     // Keep alive
-    payload.append(static_cast<char>((m_keepAliveInterval / 1000) >> 8));
-    payload.append(static_cast<char>((m_keepAliveInterval / 1000) & 0xFF));
+    builder.writeUint16(static_cast<quint16>(m_keepAliveInterval / 1000));
     // Client ID
-    payload.append(encodeString(m_clientId));
+    builder.writeString(m_clientId);
     // Username
     if (!m_username.isEmpty()) {
-        payload.append(encodeString(m_username));
+        builder.writeString(m_username);
     }
     // Password
     if (!m_password.isEmpty()) {
-        payload.append(encodeString(m_password));
+        builder.writeString(m_password);
     }
 
-    // Remaining length
-    packet.append(static_cast<char>(payload.length()));
-    packet.append(payload);
-
-    m_socket->write(packet);
+    // 握手报文不等待合并，立即写出
+    writePacket(builder.take());
+    flushWrites();
     qDebug() << "MQTT CONNECT sent";
 }
 
-void MqttClient::sendMqttSubscribe(const QString& topic, quint8 qos)
+void MqttClient::scheduleSubscriptionFlush()
+{
+    if (m_subscriptionFlushScheduled) {
+        return;
+    }
+    m_subscriptionFlushScheduled = true;
+    QTimer::singleShot(0, this, &MqttClient::flushSubscriptions);
+}
+
+void MqttClient::flushSubscriptions()
+{
+    m_subscriptionFlushScheduled = false;
+
+    if (!isConnected()) {
+        return; // 连接成功后会整体恢复订阅
+    }
+
+    if (!m_pendingUnsubscribes.isEmpty()) {
+        const QStringList topics(m_pendingUnsubscribes.cbegin(), m_pendingUnsubscribes.cend());
+        m_pendingUnsubscribes.clear();
+        sendMqttUnsubscribe(topics);
+    }
+
+    if (!m_pendingSubscribes.isEmpty()) {
+        const QStringList topics(m_pendingSubscribes.cbegin(), m_pendingSubscribes.cend());
+        m_pendingSubscribes.clear();
+        sendMqttSubscribe(topics);
+    }
+}
+
+void MqttClient::sendMqttSubscribe(const QStringList& topics)
 {
-    QByteArray packet;
-    packet.append(static_cast<char>(MqttProtocol::SUBSCRIBE));
+    // 按报文大小上限把主题切分成若干个多主题SUBSCRIBE报文
+    int packets = 0;
+    qsizetype start = 0;
+    while (start < topics.size()) {
+        quint32 remainingLength = 2; // Message ID
+        qsizetype end = start;
+        while (end < topics.size()) {
+            const quint32 entrySize = MqttPacketBuilder::stringSize(topics[end]) + 1; // Topic filter + QoS
+            if (end > start && remainingLength + entrySize > static_cast<quint32>(m_maxSubscribePacketSize)) {
+                break;
+            }
+            remainingLength += entrySize;
+            ++end;
+        }
+
+        const quint16 msgId = calculateMessageId();
+        if (msgId == 0) {
+            // 订阅仍记录在 m_subscriptions 中，重连时会恢复
+            qWarning() << "MQTT no free packet id, SUBSCRIBE deferred for" << topics.size() - start << "topics";
+            break;
+        }
+        MqttPacketBuilder builder(MqttProtocol::SUBSCRIBE, remainingLength);
+        builder.writeUint16(msgId);
+
+        QStringList packetTopics;
+        packetTopics.reserve(end - start);
+        for (qsizetype i = start; i < end; ++i) {
+            builder.writeString(topics[i]);
+            builder.writeByte(m_subscriptions.value(topics[i], 0));
+            packetTopics.append(topics[i]);
+        }
 
-    quint16 msgId = calculateMessageId();
+        m_pendingSubacks.insert(msgId, packetTopics);
+        writePacket(builder.take());
+        ++packets;
+        start = end;
+    }
 
-    QByteArray payload;
-    // Message ID
-    payload.append(static_cast<char>(msgId >> 8));
-    payload.append(static_cast<char>(msgId & 0xFF));
-    // Topic filter
-    payload.append(encodeString(topic));
-    // QoS
-    payload.append(static_cast<char>(qos));
+    qDebug() << "MQTT SUBSCRIBE sent for" << topics.size() << "topics in" << packets << "packets";
+}
+
+void MqttClient::sendMqttUnsubscribe(const QStringList& topics)
+{
+    int packets = 0;
+    qsizetype start = 0;
+    while (start < topics.size()) {
+        quint32 remainingLength = 2; // Message ID
+        qsizetype end = start;
+        while (end < topics.size()) {
+            const quint32 entrySize = MqttPacketBuilder::stringSize(topics[end]);
+            if (end > start && remainingLength + entrySize > static_cast<quint32>(m_maxSubscribePacketSize)) {
+                break;
+            }
+            remainingLength += entrySize;
+            ++end;
+        }
 
-    // Remaining length
-    packet.append(static_cast<char>(payload.length()));
-    packet.append(payload);
+        const quint16 msgId = calculateMessageId();
+        if (msgId == 0) {
+            qWarning() << "MQTT no free packet id, UNSUBSCRIBE dropped for" << topics.size() - start << "topics";
+            break;
+        }
+        MqttPacketBuilder builder(MqttProtocol::UNSUBSCRIBE, remainingLength);
+        builder.writeUint16(msgId);
+
+        QStringList packetTopics;
+        packetTopics.reserve(end - start);
+        for (qsizetype i = start; i < end; ++i) {
+            builder.writeString(topics[i]);
+            packetTopics.append(topics[i]);
+        }
 
-    m_socket->write(packet);
-    qDebug() << "MQTT SUBSCRIBE sent for:" << topic;
+        m_pendingUnsubacks.insert(msgId, packetTopics);
+        writePacket(builder.take());
+        ++packets;
+        start = end;
+    }
+
+    qDebug() << "MQTT UNSUBSCRIBE sent for" << topics.size() << "topics in" << packets << "packets";
+}
+
+void MqttClient::handleSuback(const MqttPacket& packet)
+{
+    const quint16 packetId = readPacketId(packet);
+    const QStringList topics = m_pendingSubacks.take(packetId);
+
+    // 每个主题对应一个返回码：0x00~0x02 为授予的QoS，0x80 为失败
+    const qsizetype codes = qMin<qsizetype>(topics.size(), packet.body.size() - 2);
+    for (qsizetype i = 0; i < codes; ++i) {
+        const quint8 code = static_cast<quint8>(packet.body[2 + i]);
+        const QString& topic = topics[i];
+        if (code == 0x80) {
+            qWarning() << "MQTT subscription rejected:" << topic;
+            // 允许之后重新订阅
+            m_subscriptions.remove(topic);
+            emit subscriptionFailed(topic);
+        } else {
+            emit subscribed(topic, code);
+        }
+    }
+    markSessionDirty();
 }
 
-void MqttClient::sendMqttPublish(const QString& topic, const QByteArray& payload, quint8 qos, bool retain)
+void MqttClient::handleUnsuback(const MqttPacket& packet)
+{
+    const QStringList topics = m_pendingUnsubacks.take(readPacketId(packet));
+    for (const QString& topic : topics) {
+        emit unsubscribed(topic);
+    }
+    markSessionDirty();
+}
+
+QByteArray MqttClient::buildPublishPacket(const QString& topic, const QByteArray& payload,
+                                          quint8 qos, bool retain, quint16 packetId)
 {
-    QByteArray packet;
     quint8 header = MqttProtocol::PUBLISH;
     if (retain) header |= 0x01;
     if (qos > 0) header |= (qos << 1);
-    packet.append(static_cast<char>(header));
 
-    QByteArray data;
-    // Topic
-    data.append(encodeString(topic));
-    // Message ID (if QoS > 0)
+    // Topic + Message ID(QoS > 0) + Payload
+    const qint64 remainingLength = MqttPacketBuilder::stringSize(topic)
+                                 + (qos > 0 ? 2 : 0)
+                                 + payload.size();
+    if (!MqttPacketBuilder::fitsString(topic) || remainingLength > MqttProtocol::MAX_REMAINING_LENGTH) {
+        qWarning() << "MQTT publish payload too large:" << payload.size() << "topic:" << topic;
+        return QByteArray();
+    }
+
+    MqttPacketBuilder builder(header, static_cast<quint32>(remainingLength));
+    builder.writeString(topic);
     if (qos > 0) {
-        quint16 msgId = calculateMessageId();
-        data.append(static_cast<char>(msgId >> 8));
-        data.append(static_cast<char>(msgId & 0xFF));
+        builder.writeUint16(packetId);
+    }
+    builder.writeBytes(payload);
+
+    return builder.take();
+}
+
+void MqttClient::sendMqttAck(quint8 header, quint16 packetId)
+{
+    MqttPacketBuilder builder(header, 2);
+    builder.writeUint16(packetId);
+    writePacket(builder.take());
+}
+
+void MqttClient::writePacket(const QByteArray& packet)
+{
+    m_writeBuffer.append(packet);
+    m_writeBufferPackets++;
+
+    if (m_writeBuffer.size() >= m_maxWriteBufferBytes) {
+        flushWrites();
+        return;
+    }
+
+    if (!m_writeFlushTimer->isActive()) {
+        // 0ms 定时器在本轮事件循环处理完后触发；否则把微秒预算向上取整到毫秒
+        m_writeFlushTimer->start((m_writeBudgetUs + 999) / 1000);
+    }
+}
+
+void MqttClient::flushWrites()
+{
+    m_writeFlushTimer->stop();
+
+    if (m_writeBuffer.isEmpty()) {
+        return;
+    }
+
+    if (m_socket->state() != QTcpSocket::ConnectedState) {
+        // 连接已断开，QoS>0报文会在重连后从在途窗口重发
+        m_writeBuffer.resize(0);
+        m_writeBufferPackets = 0;
+        return;
+    }
+
+    m_socket->write(m_writeBuffer);
+    m_lastOutboundAt = m_clock.elapsed();
+
+    m_writeStats.flushes++;
+    m_writeStats.packets += m_writeBufferPackets;
+    m_writeStats.bytes += m_writeBuffer.size();
+    m_writeStats.lastPacketsPerFlush = m_writeBufferPackets;
+    m_writeStats.maxPacketsPerFlush = qMax(m_writeStats.maxPacketsPerFlush, m_writeBufferPackets);
+
+    // socket 已复制数据，保留缓冲区容量供下一批使用
+    m_writeBuffer.resize(0);
+    m_writeBufferPackets = 0;
+}
+
+void MqttClient::sendInflightPublish(quint16 packetId, const QString& topic, const QByteArray& payload,
+                                     quint8 qos, bool retain)
+{
+    QByteArray packet = buildPublishPacket(topic, payload, qos, retain, packetId);
+    if (packet.isEmpty()) {
+        emit publishDropped(packetId);
+        return;
+    }
+
+    MqttInflightMessage message;
+    message.packetId = packetId;
+    message.qos = qos;
+    message.packet = packet;
+    message.sequence = m_inflightSequence++;
+    message.sentAt = m_clock.elapsed();
+    m_inflight.insert(packetId, message);
+    markSessionDirty();
+
+    writePacket(packet);
+}
+
+void MqttClient::completeInflight(quint16 packetId)
+{
+    auto it = m_inflight.find(packetId);
+    if (it == m_inflight.end()) {
+        qDebug() << "MQTT ack for unknown packet:" << packetId;
+        return;
+    }
+
+    const qint64 latency = m_clock.elapsed() - it->sentAt;
+    m_inflight.erase(it);
+
+    m_inflightStats.acknowledged++;
+    m_inflightStats.lastAckLatencyMs = latency;
+    m_inflightStats.totalAckLatencyMs += latency;
+    m_inflightStats.maxAckLatencyMs = qMax(m_inflightStats.maxAckLatencyMs, latency);
+
+    emit publishAcknowledged(packetId, latency);
+
+    drainPendingPublishes();
+    markSessionDirty();
+}
+
+void MqttClient::retransmitInflight()
+{
+    if (m_inflight.isEmpty()) {
+        return;
+    }
+
+    // 按原始发送顺序重发
+    QList<MqttInflightMessage*> messages;
+    messages.reserve(m_inflight.size());
+    for (auto it = m_inflight.begin(); it != m_inflight.end(); ++it) {
+        messages.append(&it.value());
+    }
+    std::sort(messages.begin(), messages.end(),
+              [](const MqttInflightMessage* a, const MqttInflightMessage* b) {
+                  return a->sequence < b->sequence;
+              });
+
+    for (MqttInflightMessage* message : messages) {
+        if (message->released) {
+            sendMqttAck(MqttProtocol::PUBREL, message->packetId);
+        } else {
+            message->packet[0] = static_cast<char>(message->packet[0] | 0x08); // DUP
+            writePacket(message->packet);
+        }
+        m_inflightStats.retransmitted++;
+    }
+
+    qDebug() << "MQTT retransmitted" << messages.size() << "inflight packets";
+}
+
+void MqttClient::drainPendingPublishes()
+{
+    while (isConnected() && !m_pendingPublishes.isEmpty() && m_inflight.size() < m_maxInflight) {
+        PendingPublish pending = m_pendingPublishes.dequeue();
+        m_pendingPacketIds.remove(pending.packetId);
+        sendInflightPublish(pending.packetId, pending.topic, pending.payload, pending.qos, pending.retain);
+    }
+}
+
+void MqttClient::dropInflight()
+{
+    for (auto it = m_inflight.cbegin(); it != m_inflight.cend(); ++it) {
+        emit publishDropped(it.key());
+    }
+    for (const PendingPublish& pending : std::as_const(m_pendingPublishes)) {
+        emit publishDropped(pending.packetId);
+    }
+
+    m_inflight.clear();
+    m_pendingPublishes.clear();
+    m_pendingPacketIds.clear();
+    m_incomingQos2Ids.clear();
+
+    // 立即写回旧客户端ID的会话，之后不再恢复这些报文
+    saveSession();
+}
+
+void MqttClient::restoreSession()
+{
+    MqttSessionState state;
+    if (m_sessionStore.load(m_clientId, state)) {
+        qDebug() << "MQTT session restored for" << m_clientId << "subscriptions:" << state.subscriptions.size()
+                 << "outbound:" << state.outbound.size() << "incoming QoS 2:" << state.incomingQos2Ids.size();
+    }
+    m_sessionClientId = m_clientId;
+
+    // 内存中已有、但broker会话中没有的订阅需要补发；broker仍持有的订阅直接沿用
+    m_pendingSubscribes.clear();
+    for (auto it = m_subscriptions.cbegin(); it != m_subscriptions.cend(); ++it) {
+        if (state.subscriptions.value(it.key(), 0xFF) != it.value()) {
+            m_pendingSubscribes.insert(it.key());
+        }
+    }
+    for (auto it = state.subscriptions.cbegin(); it != state.subscriptions.cend(); ++it) {
+        if (!m_subscriptions.contains(it.key())) {
+            m_subscriptions.insert(it.key(), it.value());
+        }
+    }
+
+    m_pendingUnsubscribes.clear();
+    for (const QString& topic : std::as_const(state.pendingUnsubscribes)) {
+        if (!m_subscriptions.contains(topic)) {
+            m_pendingUnsubscribes.insert(topic);
+        }
+    }
+
+    // 按原顺序恢复未确认的出站报文，重连后置DUP位重发
+    const qint64 now = m_clock.elapsed();
+    for (const MqttSessionState::OutboundMessage& outbound : std::as_const(state.outbound)) {
+        if (m_inflight.contains(outbound.packetId) || m_pendingPacketIds.contains(outbound.packetId)) {
+            continue;
+        }
+        if (outbound.packet.isEmpty()) {
+            m_pendingPublishes.enqueue({outbound.packetId, outbound.topic, outbound.payload,
+                                        outbound.qos, outbound.retain});
+            m_pendingPacketIds.insert(outbound.packetId);
+        } else {
+            MqttInflightMessage message;
+            message.packetId = outbound.packetId;
+            message.qos = outbound.qos;
+            message.packet = outbound.packet;
+            message.sequence = m_inflightSequence++;
+            message.sentAt = now;
+            message.released = outbound.released;
+            m_inflight.insert(message.packetId, message);
+        }
+    }
+
+    for (quint16 packetId : std::as_const(state.incomingQos2Ids)) {
+        m_incomingQos2Ids.insert(packetId);
+    }
+
+    // 报文ID接着上次继续分配
+    if (state.lastPacketId != 0) {
+        m_messageId = state.lastPacketId;
+    }
+}
+
+void MqttClient::markSessionDirty()
+{
+    if (!m_cleanSession && !m_sessionClientId.isEmpty() && !m_sessionSaveTimer->isActive()) {
+        m_sessionSaveTimer->start();
+    }
+}
+
+void MqttClient::saveSession()
+{
+    m_sessionSaveTimer->stop();
+    if (m_cleanSession || m_sessionClientId.isEmpty()) {
+        return;
+    }
+
+    MqttSessionState state;
+
+    // 只保存broker已经持有的订阅：尚未发送或未收到SUBACK的订阅下次仍需发送
+    QSet<QString> unconfirmed = m_pendingSubscribes;
+    for (auto it = m_pendingSubacks.cbegin(); it != m_pendingSubacks.cend(); ++it) {
+        for (const QString& topic : it.value()) {
+            unconfirmed.insert(topic);
+        }
+    }
+    for (auto it = m_subscriptions.cbegin(); it != m_subscriptions.cend(); ++it) {
+        if (!unconfirmed.contains(it.key())) {
+            state.subscriptions.insert(it.key(), it.value());
+        }
+    }
+
+    QSet<QString> unsubscribes = m_pendingUnsubscribes;
+    for (auto it = m_pendingUnsubacks.cbegin(); it != m_pendingUnsubacks.cend(); ++it) {
+        for (const QString& topic : it.value()) {
+            if (!m_subscriptions.contains(topic)) {
+                unsubscribes.insert(topic);
+            }
+        }
+    }
+    state.pendingUnsubscribes = QStringList(unsubscribes.cbegin(), unsubscribes.cend());
+
+    QList<const MqttInflightMessage*> inflight;
+    inflight.reserve(m_inflight.size());
+    for (auto it = m_inflight.cbegin(); it != m_inflight.cend(); ++it) {
+        inflight.append(&it.value());
+    }
+    std::sort(inflight.begin(), inflight.end(),
+              [](const MqttInflightMessage* a, const MqttInflightMessage* b) {
+                  return a->sequence < b->sequence;
+              });
+    for (const MqttInflightMessage* message : std::as_const(inflight)) {
+        MqttSessionState::OutboundMessage outbound;
+        outbound.packetId = message->packetId;
+        outbound.qos = message->qos;
+        outbound.packet = message->packet;
+        outbound.released = message->released;
+        state.outbound.append(outbound);
+    }
+    for (const PendingPublish& pending : std::as_const(m_pendingPublishes)) {
+        MqttSessionState::OutboundMessage outbound;
+        outbound.packetId = pending.packetId;
+        outbound.qos = pending.qos;
+        outbound.topic = pending.topic;
+        outbound.payload = pending.payload;
+        outbound.retain = pending.retain;
+        state.outbound.append(outbound);
     }
-    // Payload
-    data.append(payload);
 
-    // Remaining length (simplified, not handling multi-byte)
-    packet.append(static_cast<char>(data.length() & 0xFF));
-    packet.append(data);
+    state.incomingQos2Ids = QList<quint16>(m_incomingQos2Ids.cbegin(), m_incomingQos2Ids.cend());
+    state.lastPacketId = m_messageId;
 
-    m_socket->write(packet);
+    if (!m_sessionStore.save(m_sessionClientId, state)) {
+        qWarning() << "MQTT failed to save session for" << m_sessionClientId;
+    }
 }
 
-QByteArray MqttClient::encodeString(const QString& str)
+quint16 MqttClient::readPacketId(const MqttPacket& packet)
 {
-    QByteArray result;
-    QByteArray utf8 = str.toUtf8();
-    result.append(static_cast<char>(utf8.length() >> 8));
-    result.append(static_cast<char>(utf8.length() & 0xFF));
-    result.append(utf8);
-    return result;
+    if (packet.body.size() < 2) {
+        return 0;
+    }
+    return static_cast<quint16>((static_cast<quint8>(packet.body[0]) << 8) |
+                                static_cast<quint8>(packet.body[1]));
 }
 
 quint16 MqttClient::calculateMessageId()
 {
-    return m_messageId++;
+    // 报文ID不能为0，也不能与在途或排队中的报文冲突；65535个ID全部占用时返回0
+    for (int tried = 0; tried < 0xFFFF; ++tried) {
+        if (++m_messageId == 0) {
+            m_messageId = 1;
+        }
+        if (!m_inflight.contains(m_messageId) && !m_pendingPacketIds.contains(m_messageId) &&
+            !m_pendingSubacks.contains(m_messageId) && !m_pendingUnsubacks.contains(m_messageId)) {
+            return m_messageId;
+        }
+    }
+    return 0;
 }
 
 void MqttClient::onConnected()
 {
     qDebug() << "MQTT TCP connected";
+    m_reader.clear();
+    m_writeBuffer.resize(0);
+    m_writeBufferPackets = 0;
+
+    // 由应用层自行合并写，关闭Nagle算法避免合并后的批次再被延迟
+    m_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
     sendMqttConnect();
 }
 
@@ -362,7 +1014,13 @@ void MqttClient::onDisconnected()
 {
     qDebug() << "MQTT disconnected";
 
+    // 在CONNACK之前断开时，连接超时不能在退避等待期间触发
+    m_connectTimeoutTimer->stop();
     m_keepAliveTimer->stop();
+    m_pingResponseTimer->stop();
+    m_writeFlushTimer->stop();
+    m_writeBuffer.resize(0);
+    m_writeBufferPackets = 0;
 
     if (!m_manualDisconnect) {
         setState(MqttConnectionState::DISCONNECTED);
@@ -397,97 +1055,256 @@ void MqttClient::onError(QAbstractSocket::SocketError error)
 
 void MqttClient::onReadyRead()
 {
-    m_readBuffer.append(m_socket->readAll());
+    m_reader.readFrom(m_socket);
+    updateLastMessageTime();
+
+    // 流式解析：逐个交出指向读取缓冲区的报文视图，整批处理完后再统一压缩缓冲区
+    MqttPacket packet;
+    MqttPacketReader::Result result;
+    while ((result = m_reader.next(packet)) == MqttPacketReader::Result::PACKET) {
+        handlePacket(packet);
+    }
 
-    // 简化的MQTT报文解析
-    while (m_readBuffer.size() >= 2) {
-        quint8 messageType = static_cast<quint8>(m_readBuffer[0]);
-        quint8 remainingLength = static_cast<quint8>(m_readBuffer[1]);
+    emit readBatchFinished();
 
-        if (m_readBuffer.size() < 2 + remainingLength) {
-            break; // 等待更多数据
-        }
+    if (result == MqttPacketReader::Result::MALFORMED) {
+        qWarning() << "MQTT malformed remaining length, dropping connection";
+        m_reader.clear();
+        m_socket->abort();
+        return;
+    }
 
-        QByteArray payload = m_readBuffer.mid(2, remainingLength);
-        m_readBuffer = m_readBuffer.mid(2 + remainingLength);
-
-        // 处理不同类型的报文
-        quint8 cmd = messageType & 0xF0;
-        switch (cmd) {
-            case MqttProtocol::CONNACK: {
-                qDebug() << "MQTT CONNACK received";
-                m_connectTimeoutTimer->stop();
-                m_reconnectTimer->stop();
-                m_currentReconnectAttempt = 0;
-                setState(MqttConnectionState::CONNECTED);
-                updateLastMessageTime();
-                startKeepAlive();
-
-                // 重新订阅所有主题
-                for (auto it = m_subscriptions.begin(); it != m_subscriptions.end(); ++it) {
-                    sendMqttSubscribe(it.key(), it.value());
-                }
+    m_reader.compact();
+}
 
-                emit connected();
+void MqttClient::handlePacket(const MqttPacket& packet)
+{
+    // 处理不同类型的报文
+    switch (packet.type()) {
+        case MqttProtocol::CONNACK: {
+            qDebug() << "MQTT CONNACK received";
+            m_connectTimeoutTimer->stop();
+            m_reconnectTimer->stop();
+            setState(MqttConnectionState::CONNECTED);
+
+            if (m_disconnectedAt >= 0) {
+                const qint64 duration = m_clock.elapsed() - m_disconnectedAt;
+                m_reconnectStats.record(duration);
+                qDebug() << "MQTT reconnected after" << m_currentReconnectAttempt
+                         << "attempts in" << duration << "ms";
+                emit reconnected(m_currentReconnectAttempt, duration);
+            }
+            m_currentReconnectAttempt = 0;
+            m_disconnectedAt = -1;
+            startKeepAlive(m_keepAliveInterval);
+
+            // 连接确认标志 bit0：broker是否保留了之前的会话
+            const bool sessionPresent = !m_cleanSession && !packet.body.isEmpty() &&
+                                        (static_cast<quint8>(packet.body[0]) & 0x01) != 0;
+
+            if (sessionPresent) {
+                // broker仍持有订阅，只补发离线期间的增量以及断线时未确认的请求
+                for (auto it = m_pendingSubacks.cbegin(); it != m_pendingSubacks.cend(); ++it) {
+                    for (const QString& topic : it.value()) {
+                        if (m_subscriptions.contains(topic)) {
+                            m_pendingSubscribes.insert(topic);
+                        }
+                    }
+                }
+                for (auto it = m_pendingUnsubacks.cbegin(); it != m_pendingUnsubacks.cend(); ++it) {
+                    for (const QString& topic : it.value()) {
+                        if (!m_subscriptions.contains(topic)) {
+                            m_pendingUnsubscribes.insert(topic);
+                        }
+                    }
+                }
+                m_pendingSubacks.clear();
+                m_pendingUnsubacks.clear();
+                flushSubscriptions();
+                qDebug() << "MQTT session present, skipped resubscribe of" << m_subscriptions.size() << "topics";
+            } else {
+                // 合并成少量多主题SUBSCRIBE报文，恢复所有订阅
+                m_pendingSubscribes.clear();
+                m_pendingUnsubscribes.clear();
+                m_pendingSubacks.clear();
+                m_pendingUnsubacks.clear();
+                if (!m_subscriptions.isEmpty()) {
+                    sendMqttSubscribe(m_subscriptions.keys());
+                }
 
-                if (m_connectedCallback) {
-                    m_connectedCallback();
+                // 新会话的报文ID重新开始，旧的QoS 2记录会把新消息误判为重复投递而丢弃
+                if (!m_incomingQos2Ids.isEmpty()) {
+                    m_incomingQos2Ids.clear();
+                    saveSession();
                 }
-                break;
             }
-            case MqttProtocol::PUBLISH: {
-                // 简化的PUBLISH解析
-                int topicLen = (static_cast<quint8>(payload[0]) << 8) | static_cast<quint8>(payload[1]);
-                QString topic = QString::fromUtf8(payload.mid(2, topicLen));
-                QByteArray messagePayload = payload.mid(2 + topicLen);
+            emit sessionResumed(sessionPresent);
 
-                qDebug() << "MQTT message received, topic:" << topic << "size:" << messagePayload.size();
+            // 重发未确认的QoS 1/2报文，再继续发送排队中的报文
+            retransmitInflight();
+            drainPendingPublishes();
 
-                emit messageReceived(topic, messagePayload);
+            emit connected();
 
-                if (m_messageCallback) {
-                    m_messageCallback(topic, messagePayload);
-                }
-                break;
+            if (m_connectedCallback) {
+                m_connectedCallback();
             }
-            case MqttProtocol::PINGRESP: {
-                qDebug() << "MQTT PINGRESP received";
-                updateLastMessageTime();
+            break;
+        }
+        case MqttProtocol::PUBLISH: {
+            MqttPublishView publish;
+            if (!MqttPacketReader::parsePublish(packet, publish)) {
+                qWarning() << "MQTT malformed PUBLISH packet, size:" << packet.body.size();
                 break;
             }
-            default:
-                qDebug() << "MQTT unhandled message type:" << Qt::hex << cmd;
+
+            // QoS 2 重复投递：之前已经分发过，只需再次回复PUBREC
+            if (publish.qos == 2 && m_incomingQos2Ids.contains(publish.packetId)) {
+                sendMqttAck(MqttProtocol::PUBREC, publish.packetId);
                 break;
+            }
+
+            QString topic = QString::fromUtf8(publish.topic);
+            // 零拷贝：载荷直接引用读取缓冲区，仅在本次分发期间有效
+            const QByteArray messagePayload = QByteArray::fromRawData(
+                publish.payload.data(), publish.payload.size());
+
+            qDebug() << "MQTT message received, topic:" << topic << "size:" << messagePayload.size();
+
+            emit messageReceived(topic, messagePayload);
+
+            if (m_messageCallback) {
+                m_messageCallback(topic, messagePayload);
+            }
+
+            if (publish.qos == 1) {
+                sendMqttAck(MqttProtocol::PUBACK, publish.packetId);
+            } else if (publish.qos == 2) {
+                m_incomingQos2Ids.insert(publish.packetId);
+                markSessionDirty();
+                sendMqttAck(MqttProtocol::PUBREC, publish.packetId);
+            }
+            break;
+        }
+        case MqttProtocol::SUBACK: {
+            handleSuback(packet);
+            break;
+        }
+        case MqttProtocol::UNSUBACK: {
+            handleUnsuback(packet);
+            break;
+        }
+        case MqttProtocol::PUBACK: {
+            completeInflight(readPacketId(packet));
+            break;
+        }
+        case MqttProtocol::PUBREC: {
+            const quint16 packetId = readPacketId(packet);
+            auto it = m_inflight.find(packetId);
+            if (it != m_inflight.end()) {
+                it->released = true;
+                markSessionDirty();
+            }
+            sendMqttAck(MqttProtocol::PUBREL, packetId);
+            break;
+        }
+        case MqttProtocol::PUBREL & 0xF0: {
+            const quint16 packetId = readPacketId(packet);
+            if (m_incomingQos2Ids.remove(packetId)) {
+                markSessionDirty();
+            }
+            sendMqttAck(MqttProtocol::PUBCOMP, packetId);
+            break;
+        }
+        case MqttProtocol::PUBCOMP: {
+            completeInflight(readPacketId(packet));
+            break;
         }
+        case MqttProtocol::PINGRESP: {
+            if (m_pingResponseTimer->isActive()) {
+                m_pingResponseTimer->stop();
+                const qint64 roundTrip = m_clock.elapsed() - m_pingSentAt;
+                m_keepAliveStats.pongsReceived++;
+                m_keepAliveStats.lastRoundTripMs = roundTrip;
+                m_keepAliveStats.maxRoundTripMs = qMax(m_keepAliveStats.maxRoundTripMs, roundTrip);
+                emit keepAliveDecision(MqttKeepAliveDecision::PONG_RECEIVED, roundTrip);
+                qDebug() << "MQTT PINGRESP received, rtt:" << roundTrip << "ms";
+            }
+            scheduleKeepAlive();
+            break;
+        }
+        default:
+            qDebug() << "MQTT unhandled message type:" << Qt::hex << packet.type();
+            break;
     }
 }
 
 void MqttClient::onKeepAliveTimeout()
 {
-    if (!isConnected()) {
-        m_keepAliveTimer->stop();
+    if (!isConnected() || m_pingResponseTimer->isActive()) {
+        return; // 已在等待PINGRESP，由截止定时器处理
+    }
+
+    const qint64 now = m_clock.elapsed();
+    const qint64 inboundIdle = now - m_lastInboundAt;
+    const qint64 outboundIdle = now - m_lastOutboundAt;
+
+    // 入站流量证明链路存活，出站流量满足broker的心跳要求，两者都近期有过时无需探测
+    if (inboundIdle < m_keepAliveInterval && outboundIdle < m_keepAliveInterval) {
+        m_keepAliveStats.pingsSkipped++;
+        emit keepAliveDecision(MqttKeepAliveDecision::PING_SKIPPED, qMax(inboundIdle, outboundIdle));
+        scheduleKeepAlive();
         return;
     }
 
-    // 发送PINGREQ
-    QByteArray packet;
-    packet.append(static_cast<char>(MqttProtocol::PINGREQ));
-    packet.append(static_cast<char>(0x00));
-    m_socket->write(packet);
+    // 发送PINGREQ，不等待合并
+    MqttPacketBuilder builder(MqttProtocol::PINGREQ, 0);
+    writePacket(builder.take());
+    flushWrites();
+
+    m_pingSentAt = now;
+    m_pingResponseTimer->start(m_pingTimeout);
+    m_keepAliveStats.pingsSent++;
+    emit keepAliveDecision(MqttKeepAliveDecision::PING_SENT, qMax(inboundIdle, outboundIdle));
 
-    qDebug() << "MQTT PINGREQ sent";
+    qDebug() << "MQTT PINGREQ sent, idle in:" << inboundIdle << "ms out:" << outboundIdle << "ms";
+}
+
+void MqttClient::onPingResponseTimeout()
+{
+    const qint64 waited = m_clock.elapsed() - m_pingSentAt;
+    m_keepAliveStats.pongTimeouts++;
+    emit keepAliveDecision(MqttKeepAliveDecision::PONG_TIMEOUT, waited);
+
+    // 半开连接（休眠唤醒、NAT超时等）：直接中断，由 onDisconnected 进入重连
+    qWarning() << "MQTT PINGRESP not received within" << m_pingTimeout << "ms, dropping connection";
+    m_socket->abort();
 }
 
 void MqttClient::onConnectTimeout()
 {
-    if (m_state == MqttConnectionState::CONNECTING) {
+    const MqttConnectionState state = m_state.load();
+    if (state == MqttConnectionState::CONNECTING || state == MqttConnectionState::RECONNECTING) {
         QString error = "Connection timeout";
         qWarning() << "MQTT connection timeout:" << error;
 
         setState(MqttConnectionState::ERROR);
-        disconnectFromHost();
+        m_socket->abort();
         scheduleReconnect();
     }
 }
 
+void MqttClient::onReachabilityChanged(QNetworkInformation::Reachability reachability)
+{
+    if (reachability != QNetworkInformation::Reachability::Online || m_manualDisconnect ||
+        m_host.isEmpty() || isConnected()) {
+        return;
+    }
+
+    // 网络恢复：跳过剩余的退避时间，并重置退避
+    qDebug() << "MQTT network back online, reconnecting immediately";
+    m_currentReconnectAttempt = 0;
+    reconnect();
+}
+
 } // namespace Bytedesk
@@ -4,11 +4,17 @@
 #include <QObject>
 #include <QString>
 #include <QHash>
+#include <QSet>
+#include <QQueue>
 #include <QTimer>
-#include <QMutex>
+#include <QElapsedTimer>
 #include <QTcpSocket>
+#include <QNetworkInformation>
 #include <functional>
+#include <atomic>
 
+#include "mqttpacket.h"
+#include "mqttsessionstore.h"
 #include "models/message.h"
 #include "models/thread.h"
 #include "models/user.h"
@@ -24,6 +30,88 @@ enum class MqttConnectionState {
     ERROR = 4
 };
 
+// 已发送但尚未被broker确认的QoS>0报文
+struct MqttInflightMessage {
+    quint16 packetId = 0;
+    quint8 qos = 0;
+    QByteArray packet;      // 完整的PUBLISH帧，重连后置DUP位重发
+    quint64 sequence = 0;   // 发送顺序，重发时按此排序
+    qint64 sentAt = 0;      // 首次发送时间（单调时钟，毫秒）
+    bool released = false;  // QoS 2：已收到PUBREC并发送PUBREL，等待PUBCOMP
+};
+
+// 在途窗口统计
+struct MqttInflightStats {
+    int inflight = 0;               // 当前在途报文数
+    int queued = 0;                 // 窗口已满而排队的报文数
+    quint64 acknowledged = 0;       // 已确认报文总数
+    quint64 retransmitted = 0;      // 重发报文总数
+    qint64 lastAckLatencyMs = 0;
+    qint64 maxAckLatencyMs = 0;
+    qint64 totalAckLatencyMs = 0;
+
+    qint64 averageAckLatencyMs() const {
+        return acknowledged > 0 ? totalAckLatencyMs / static_cast<qint64>(acknowledged) : 0;
+    }
+};
+
+// 出站合并写统计
+struct MqttWriteStats {
+    quint64 flushes = 0;            // 实际调用 socket write 的次数
+    quint64 packets = 0;            // 写出的报文总数
+    quint64 bytes = 0;              // 写出的字节总数
+    int lastPacketsPerFlush = 0;
+    int maxPacketsPerFlush = 0;
+
+    double averagePacketsPerFlush() const {
+        return flushes > 0 ? static_cast<double>(packets) / static_cast<double>(flushes) : 0.0;
+    }
+};
+
+// 心跳决策
+enum class MqttKeepAliveDecision {
+    PING_SKIPPED = 0,   // 双向都有近期流量，无需探测
+    PING_SENT = 1,      // 发送PINGREQ并开始等待PINGRESP
+    PONG_RECEIVED = 2,  // 在截止时间内收到PINGRESP
+    PONG_TIMEOUT = 3    // 超时未收到PINGRESP，判定连接已死并重连
+};
+
+// 心跳统计
+struct MqttKeepAliveStats {
+    quint64 pingsSent = 0;
+    quint64 pingsSkipped = 0;
+    quint64 pongsReceived = 0;
+    quint64 pongTimeouts = 0;
+    qint64 lastRoundTripMs = 0;
+    qint64 maxRoundTripMs = 0;
+};
+
+// 重连统计：从断开到重新收到CONNACK的耗时分布
+struct MqttReconnectStats {
+    static constexpr int BUCKET_COUNT = 9;
+    // 各桶上限（毫秒），最后一桶为 60s 以上
+    static constexpr qint64 BUCKET_BOUNDS_MS[BUCKET_COUNT - 1] = {
+        100, 500, 1000, 2000, 5000, 10000, 30000, 60000
+    };
+
+    quint64 attempts = 0;               // 发起的重连尝试总数
+    quint64 reconnects = 0;             // 成功重连次数
+    qint64 lastReconnectMs = 0;
+    qint64 maxReconnectMs = 0;
+    quint64 buckets[BUCKET_COUNT] = {};
+
+    void record(qint64 durationMs) {
+        int bucket = 0;
+        while (bucket < BUCKET_COUNT - 1 && durationMs > BUCKET_BOUNDS_MS[bucket]) {
+            ++bucket;
+        }
+        buckets[bucket]++;
+        reconnects++;
+        lastReconnectMs = durationMs;
+        maxReconnectMs = qMax(maxReconnectMs, durationMs);
+    }
+};
+
 // MQTT消息回调类型
 using MqttMessageCallback = std::function<void(const QString& topic, const QByteArray& message)>;
 using MqttConnectedCallback = std::function<void()>;
@@ -33,6 +121,10 @@ using MqttErrorCallback = std::function<void(const QString& error)>;
 // MQTT客户端类 - 使用TCP socket的简化实现
 // 注意：这是一个简化的MQTT实现，用于演示目的
 // 生产环境建议使用完整的MQTT库或Qt MQTT模块
+//
+// 线程：客户端可以 moveToThread() 到独立的网络线程。连接和订阅管理接口
+// 可在任意线程调用（自动转发到客户端所在线程），isConnected() 读取原子状态；
+// publish() 需要返回报文ID，必须在客户端所在线程调用
 class MqttClient : public QObject
 {
     Q_OBJECT
@@ -45,18 +137,37 @@ public:
     void connectToHost(const QString& host, int port, const QString& username,
                       const QString& password, const QString& clientId);
     void disconnectFromHost();
+    // 立即发起一次重连尝试（非主动断开时由重连状态机自动调用）
     void reconnect();
 
     bool isConnected() const;
-    MqttConnectionState getConnectionState() const { return m_state; }
+    MqttConnectionState getConnectionState() const { return m_state.load(); }
 
     // 订阅管理
+    // 订阅/取消订阅会被记录下来，并在同一轮事件循环内合并成多主题的
+    // SUBSCRIBE/UNSUBSCRIBE报文发送；未连接时只记录，连接成功后统一恢复
     void subscribe(const QString& topic, quint8 qos = 0);
     void unsubscribe(const QString& topic);
     void unsubscribeAll();
+    bool isSubscribed(const QString& topic) const { return m_subscriptions.contains(topic); }
+
+    // 单个SUBSCRIBE/UNSUBSCRIBE报文的最大字节数
+    void setMaxSubscribePacketSize(int bytes);
 
     // 消息发布
-    void publish(const QString& topic, const QByteArray& payload, quint8 qos = 0, bool retain = false);
+    // QoS>0 时返回报文ID（窗口已满时先排队，队列已满或报文ID耗尽时丢弃），QoS 0 或发送失败时返回0
+    quint16 publish(const QString& topic, const QByteArray& payload, quint8 qos = 0, bool retain = false);
+
+    // 在途窗口
+    void setMaxInflight(int maxInflight);
+    int getMaxInflight() const { return m_maxInflight; }
+    MqttInflightStats getInflightStats() const;
+
+    // 出站合并写
+    // 同一轮事件循环（或 budgetUs 微秒内）产生的报文合并成一次 socket write；
+    // budgetUs 为0时在本轮事件循环结束时写出，缓冲超过 maxBytes 时立即写出
+    void setWriteCoalescing(int budgetUs, int maxBytes = 64 * 1024);
+    MqttWriteStats getWriteStats() const { return m_writeStats; }
 
     // 回调设置
     void setMessageCallback(MqttMessageCallback callback);
@@ -65,14 +176,26 @@ public:
     void setErrorCallback(MqttErrorCallback callback);
 
     // 心跳和重连
+    // 心跳定时器只在最早可能需要探测的时刻唤醒：入站和出站在一个心跳周期内
+    // 都有流量时跳过PINGREQ；发出PINGREQ后超过 pingTimeout 未收到PINGRESP
+    // 则中断连接并进入重连
     void startKeepAlive(int intervalMs = 30000);
     void stopKeepAlive();
+    void setPingTimeout(int milliseconds);
+    MqttKeepAliveStats getKeepAliveStats() const { return m_keepAliveStats; }
 
     // 配置
     void setKeepAlive(int seconds);
+    // 重连退避：首次立即重试，之后延迟在 [0, min(max, interval * 2^(n-1))] 内随机，
+    // 不会放弃；网络恢复时立即重试
     void setReconnectInterval(int milliseconds);
+    void setMaxReconnectDelay(int milliseconds);
+    MqttReconnectStats getReconnectStats() const { return m_reconnectStats; }
     void setConnectTimeout(int milliseconds);
+    // cleanSession 为 false 时启用持久会话：订阅、未确认的出站报文和入站QoS 2状态
+    // 保存在本地，重启后用同一客户端ID连接，broker返回 session present 时不再重新订阅
     void setCleanSession(bool clean);
+    void setSessionStoreDirectory(const QString& directory);
     void setWillMessage(const QString& topic, const QByteArray& message, quint8 qos);
 
     QString getClientId() const { return m_clientId; }
@@ -82,8 +205,26 @@ signals:
     void connected();
     void disconnected();
     void errorOccurred(const QString& error);
+    // payload 直接引用内部读取缓冲区（零拷贝），只在信号处理期间有效；
+    // 需要保存时请先深拷贝，例如 QByteArray(payload.constData(), payload.size())
     void messageReceived(const QString& topic, const QByteArray& payload);
+    // 一次 readyRead 中的报文全部分发完毕，可在此回收按批次复用的解码资源
+    void readBatchFinished();
     void connectionStateChanged(MqttConnectionState state);
+    // QoS>0 报文被broker确认（QoS 1: PUBACK，QoS 2: PUBCOMP）
+    void publishAcknowledged(quint16 packetId, qint64 latencyMs);
+    // 在途报文被丢弃（例如切换了客户端ID，会话不再延续）
+    void publishDropped(quint16 packetId);
+    // SUBACK/UNSUBACK 按主题逐个回报
+    void subscribed(const QString& topic, quint8 grantedQos);
+    void subscriptionFailed(const QString& topic);
+    void unsubscribed(const QString& topic);
+    // 每次心跳决策；idleMs 为决策时的空闲时长（PONG_* 时为往返耗时）
+    void keepAliveDecision(MqttKeepAliveDecision decision, qint64 idleMs);
+    // 断线后重新连接成功；attempts 为本次断线期间的尝试次数
+    void reconnected(int attempts, qint64 durationMs);
+    // CONNACK中的 session present 标志
+    void sessionResumed(bool sessionPresent);
 
 private slots:
     void onConnected();
@@ -91,22 +232,54 @@ private slots:
     void onError(QAbstractSocket::SocketError error);
     void onReadyRead();
     void onKeepAliveTimeout();
+    void onPingResponseTimeout();
+    void onReachabilityChanged(QNetworkInformation::Reachability reachability);
     void onConnectTimeout();
 
 private:
     void setState(MqttConnectionState state);
     void scheduleReconnect();
+    int nextReconnectDelay() const;
     void updateLastMessageTime();
+    void scheduleKeepAlive();
+    void handlePacket(const MqttPacket& packet);
     void sendMqttConnect();
-    void sendMqttSubscribe(const QString& topic, quint8 qos);
-    void sendMqttPublish(const QString& topic, const QByteArray& payload, quint8 qos, bool retain);
+    void scheduleSubscriptionFlush();
+    void flushSubscriptions();
+    void sendMqttSubscribe(const QStringList& topics);
+    void sendMqttUnsubscribe(const QStringList& topics);
+    void handleSuback(const MqttPacket& packet);
+    void handleUnsuback(const MqttPacket& packet);
+    QByteArray buildPublishPacket(const QString& topic, const QByteArray& payload,
+                                  quint8 qos, bool retain, quint16 packetId);
+    void sendMqttAck(quint8 header, quint16 packetId);
+
+    // 出站合并写
+    void writePacket(const QByteArray& packet);
+    void flushWrites();
+
+    // QoS 1/2 在途窗口
+    void sendInflightPublish(quint16 packetId, const QString& topic, const QByteArray& payload,
+                             quint8 qos, bool retain);
+    void completeInflight(quint16 packetId);
+    void retransmitInflight();
+    void drainPendingPublishes();
+    void dropInflight();
+
+    // 持久会话
+    void restoreSession();
+    void markSessionDirty();
+    void saveSession();
+    static quint16 readPacketId(const MqttPacket& packet);
 
     // MQTT协议相关方法
-    QByteArray encodeString(const QString& str);
     quint16 calculateMessageId();
 
+    // 是否需要转发到客户端所在线程执行
+    bool isOtherThread() const;
+
     QTcpSocket* m_socket;
-    MqttConnectionState m_state;
+    std::atomic<MqttConnectionState> m_state;
     QString m_clientId;
     QString m_host;
     int m_port;
@@ -116,6 +289,12 @@ private:
 
     // 订阅管理
     QHash<QString, quint8> m_subscriptions;
+    QSet<QString> m_pendingSubscribes;            // 待合并发送的订阅
+    QSet<QString> m_pendingUnsubscribes;          // 待合并发送的取消订阅
+    QHash<quint16, QStringList> m_pendingSubacks; // packetId -> 报文中的主题（按顺序）
+    QHash<quint16, QStringList> m_pendingUnsubacks;
+    int m_maxSubscribePacketSize;
+    bool m_subscriptionFlushScheduled;
 
     // 回调函数
     MqttMessageCallback m_messageCallback;
@@ -127,24 +306,61 @@ private:
     QTimer* m_keepAliveTimer;
     QTimer* m_reconnectTimer;
     QTimer* m_connectTimeoutTimer;
+    QTimer* m_pingResponseTimer;
 
-    QDateTime m_lastMessageTime;
+    // 最近一次收到/发出数据的时间（单调时钟，毫秒）
+    qint64 m_lastInboundAt;
+    qint64 m_lastOutboundAt;
+    qint64 m_pingSentAt;
+    int m_pingTimeout;
+    MqttKeepAliveStats m_keepAliveStats;
     int m_keepAliveInterval;
     int m_reconnectInterval;
+    int m_maxReconnectDelay;
     int m_connectTimeout;
-    int m_maxReconnectAttempts;
     int m_currentReconnectAttempt;
+    qint64 m_disconnectedAt;            // 本次断线开始时间，-1 表示未处于断线重连中
+    MqttReconnectStats m_reconnectStats;
     bool m_manualDisconnect;
     quint16 m_messageId;
 
+    // QoS 1/2 在途窗口
+    struct PendingPublish {
+        quint16 packetId;
+        QString topic;
+        QByteArray payload;
+        quint8 qos;
+        bool retain;
+    };
+    QHash<quint16, MqttInflightMessage> m_inflight;
+    QQueue<PendingPublish> m_pendingPublishes;
+    static constexpr int MAX_PENDING_PUBLISHES = 10000; // 窗口满时最多排队的报文数
+    QSet<quint16> m_pendingPacketIds;
+    QSet<quint16> m_incomingQos2Ids; // 已收到但尚未收到PUBREL的QoS 2报文
+    int m_maxInflight;
+    quint64 m_inflightSequence;
+    MqttInflightStats m_inflightStats;
+    QElapsedTimer m_clock;
+
+    // 持久会话
+    MqttSessionStore m_sessionStore;
+    QString m_sessionClientId;  // 已从存储恢复过的客户端ID
+    QTimer* m_sessionSaveTimer;
+
     QString m_willTopic;
     QByteArray m_willMessage;
     quint8 m_willQos;
 
-    QMutex m_mutex;
+    // 出站合并写缓冲
+    QByteArray m_writeBuffer;
+    int m_writeBufferPackets;
+    QTimer* m_writeFlushTimer;
+    int m_writeBudgetUs;
+    int m_maxWriteBufferBytes;
+    MqttWriteStats m_writeStats;
 
-    // 读取缓冲区
-    QByteArray m_readBuffer;
+    // 读取缓冲区（流式解码）
+    MqttPacketReader m_reader;
 };
 
 } // namespace Bytedesk
@@ -0,0 +1,189 @@
+#include "mqttdecodepipeline.h"
+#include <QThreadPool>
+#include <QCoreApplication>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <utility>
+
+namespace Bytedesk {
+
+MqttDecodePipeline::MqttDecodePipeline(int parallelism, DecodeFunction decode, QObject* parent)
+    : QObject(parent)
+    , m_pool(new QThreadPool(this))
+    , m_decode(std::move(decode))
+    , m_flushScheduled(false)
+{
+    m_pool->setMaxThreadCount(qMax(1, parallelism));
+    m_pool->setObjectName("MqttDecodePool");
+
+    for (int i = 0; i < m_pool->maxThreadCount(); ++i) {
+        m_decoders.push_back(std::make_unique<ProtobufDecoder>());
+        m_decoderStats.emplace_back();
+        m_idleWorkers.append(i);
+    }
+    qDebug() << "MQTT decode pipeline started, parallelism:" << m_pool->maxThreadCount();
+}
+
+MqttDecodePipeline::~MqttDecodePipeline()
+{
+    // 工作线程会回调本对象，必须先等它们结束；未开始解码的载荷直接丢弃，需要保留时先调用 drain()
+    {
+        QMutexLocker locker(&m_queueMutex);
+        m_queue.clear();
+    }
+    m_pool->waitForDone();
+}
+
+int MqttDecodePipeline::parallelism() const
+{
+    return m_pool->maxThreadCount();
+}
+
+MqttDecodeStats MqttDecodePipeline::getStats() const
+{
+    // 可在任意线程调用：统计在锁内更新，这里取一致的快照
+    QMutexLocker locker(&m_queueMutex);
+    MqttDecodeStats stats = m_stats;
+    for (const ProtobufDecodeStats& decoderStats : m_decoderStats) {
+        stats.decoder.merge(decoderStats);
+    }
+    return stats;
+}
+
+void MqttDecodePipeline::submit(const QString& lane, const QString& topic, const MqttTopicRoute& route,
+                                QByteArrayView payload)
+{
+    const quint64 sequence = m_lanes[lane].nextSequence++;
+
+    // 深拷贝：入站载荷指向socket读缓冲区，返回后就会被复用
+    Job job{lane, sequence, topic, route, QByteArray(payload.data(), payload.size())};
+
+    int worker = -1;
+    {
+        QMutexLocker locker(&m_queueMutex);
+        m_stats.submitted++;
+        m_stats.inFlight++;
+        m_stats.maxInFlight = qMax(m_stats.maxInFlight, m_stats.inFlight);
+
+        m_queue.enqueue(std::move(job));
+        if (!m_idleWorkers.isEmpty()) {
+            worker = m_idleWorkers.takeLast();
+        }
+    }
+
+    // 所有工作任务都在运行时，它们会在排空队列前取到这个载荷
+    if (worker >= 0) {
+        m_pool->start([this, worker]() { run(worker); });
+    }
+}
+
+void MqttDecodePipeline::run(int worker)
+{
+    ProtobufDecoder& decoder = *m_decoders[worker];
+
+    for (;;) {
+        Job job;
+        {
+            QMutexLocker locker(&m_queueMutex);
+            if (m_queue.isEmpty()) {
+                // 队列排空即一批结束：回收Arena（保留初始块），发布统计后归还
+                decoder.reset();
+                m_decoderStats[worker] = decoder.getStats();
+                m_idleWorkers.append(worker);
+                return;
+            }
+            job = m_queue.dequeue();
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        MqttDecodedPayload result;
+        result.topic = job.topic;
+        result.route = job.route;
+        result.messages = m_decode(job.data, decoder);
+
+        const qint64 decodeUs = timer.nsecsElapsed() / 1000;
+        QMetaObject::invokeMethod(this, [this, lane = job.lane, sequence = job.sequence, result, decodeUs]() {
+            onDecoded(lane, sequence, result, decodeUs);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void MqttDecodePipeline::drain()
+{
+    Q_ASSERT_X(thread() == QThread::currentThread(), "MqttDecodePipeline::drain",
+               "must be called from the pipeline's thread");
+
+    m_pool->waitForDone();
+
+    // 工作线程投递的结果还在事件队列里，就地处理后立即发出
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+    flush();
+}
+
+void MqttDecodePipeline::onDecoded(const QString& lane, quint64 sequence,
+                                   const MqttDecodedPayload& result, qint64 decodeUs)
+{
+    {
+        QMutexLocker locker(&m_queueMutex);
+        m_stats.totalDecodeUs += decodeUs;
+
+        auto it = m_lanes.find(lane);
+        if (it == m_lanes.end()) {
+            return;
+        }
+
+        Lane& state = it.value();
+        state.ready.insert(sequence, result);
+        m_stats.maxReorderDepth = qMax(m_stats.maxReorderDepth, static_cast<int>(state.ready.size()));
+
+        // 放行从 nextDelivery 开始连续就绪的结果
+        for (auto ready = state.ready.begin();
+             ready != state.ready.end() && ready.key() == state.nextDelivery;
+             ready = state.ready.erase(ready)) {
+            m_stats.delivered++;
+            m_stats.inFlight--;
+            m_stats.messages += ready.value().messages.size();
+            m_ready.append(std::move(ready.value()));
+            state.nextDelivery++;
+        }
+
+        // 通道空闲时释放，避免会话数量无限增长
+        if (state.ready.isEmpty() && state.nextDelivery == state.nextSequence) {
+            m_lanes.erase(it);
+        }
+    }
+
+    scheduleFlush();
+}
+
+void MqttDecodePipeline::scheduleFlush()
+{
+    if (m_ready.isEmpty() || m_flushScheduled) {
+        return;
+    }
+
+    // 排在已到达的解码结果之后执行，同一轮内放行的结果合并为一批
+    m_flushScheduled = true;
+    QMetaObject::invokeMethod(this, &MqttDecodePipeline::flush, Qt::QueuedConnection);
+}
+
+void MqttDecodePipeline::flush()
+{
+    m_flushScheduled = false;
+
+    const QList<MqttDecodedPayload> batch = std::exchange(m_ready, QList<MqttDecodedPayload>());
+    if (batch.isEmpty()) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_queueMutex);
+        m_stats.batches++;
+    }
+    emit decoded(batch);
+}
+
+} // namespace Bytedesk
@@ -0,0 +1,114 @@
+#ifndef MQTTDECODEPIPELINE_H
+#define MQTTDECODEPIPELINE_H
+
+#include <QObject>
+#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QQueue>
+#include <QMutex>
+#include <QByteArrayView>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "mqtttopictrie.h"
+#include "core/protobuf/protobufwrapper.h"
+#include "models/message.h"
+
+class QThreadPool;
+
+namespace Bytedesk {
+
+// 一个入站载荷的解码结果（批量信封可能包含多条消息）
+struct MqttDecodedPayload {
+    QString topic;
+    MqttTopicRoute route;
+    QList<MessagePtr> messages;
+};
+
+// 解码流水线统计
+struct MqttDecodeStats {
+    quint64 submitted = 0;      // 提交的载荷数
+    quint64 delivered = 0;      // 已按序交付的载荷数
+    quint64 messages = 0;       // 交付的消息数
+    quint64 batches = 0;        // decoded 信号次数
+    int inFlight = 0;           // 已提交、尚未交付的载荷数
+    int maxInFlight = 0;
+    int maxReorderDepth = 0;    // 单个通道中等待前序结果的最大数量
+    qint64 totalDecodeUs = 0;   // 工作线程解码耗时合计
+    ProtobufDecodeStats decoder; // 各工作线程解码器的合计（每次排空队列时更新）
+
+    double averageDecodeUs() const {
+        return delivered > 0 ? static_cast<double>(totalDecodeUs) / static_cast<double>(delivered) : 0.0;
+    }
+};
+
+// 入站并行解码流水线
+// 载荷在提交时深拷贝后进入共享队列，最多 parallelism 个工作任务并行取出解码。
+// 每个工作任务持有一个Arena解码器，连续解码直到队列排空才 reset() 一次，与同步路径的每批 readyRead 回收一致；
+// 每个通道（会话UID，未知时为主题）内按提交顺序编号，结果回到本对象所在线程后按序放行，
+// 同一轮事件循环内放行的结果合并为一批发出 decoded 信号。不同通道之间互不阻塞
+class MqttDecodePipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 在工作线程中调用，必须是无状态的
+    using DecodeFunction = std::function<QList<MessagePtr>(const QByteArray& payload, ProtobufDecoder& decoder)>;
+
+    MqttDecodePipeline(int parallelism, DecodeFunction decode, QObject* parent = nullptr);
+    ~MqttDecodePipeline();
+
+    void submit(const QString& lane, const QString& topic, const MqttTopicRoute& route,
+                QByteArrayView payload);
+
+    // 等待已提交的载荷全部解码，并在返回前同步发出 decoded；必须在本对象所在线程调用
+    void drain();
+
+    int parallelism() const;
+    // 线程安全
+    MqttDecodeStats getStats() const;
+
+signals:
+    // 按通道顺序合并后的解码结果
+    void decoded(const QList<MqttDecodedPayload>& batch);
+
+private:
+    struct Lane {
+        quint64 nextSequence = 0;   // 下一个提交的编号
+        quint64 nextDelivery = 0;   // 下一个应交付的编号
+        QMap<quint64, MqttDecodedPayload> ready; // 已解码、等待前序结果
+    };
+
+    struct Job {
+        QString lane;
+        quint64 sequence = 0;
+        QString topic;
+        MqttTopicRoute route;
+        QByteArray data;
+    };
+
+    void run(int worker);
+    void onDecoded(const QString& lane, quint64 sequence, const MqttDecodedPayload& result, qint64 decodeUs);
+    void scheduleFlush();
+    void flush();
+
+    QThreadPool* m_pool;
+    DecodeFunction m_decode;
+
+    // 以下由 m_queueMutex 保护（m_stats 也是：由本对象所在线程更新，getStats() 可在任意线程读取）
+    mutable QMutex m_queueMutex;
+    QQueue<Job> m_queue;
+    QList<int> m_idleWorkers;
+    std::vector<std::unique_ptr<ProtobufDecoder>> m_decoders;   // 每个工作任务一个
+    std::vector<ProtobufDecodeStats> m_decoderStats;            // 各解码器最近一次排空时的统计
+
+    QHash<QString, Lane> m_lanes;
+    QList<MqttDecodedPayload> m_ready;  // 已放行、等待本轮合并发出
+    bool m_flushScheduled;
+    MqttDecodeStats m_stats;
+};
+
+} // namespace Bytedesk
+
+#endif // MQTTDECODEPIPELINE_H
@@ -0,0 +1,128 @@
+#include "mqttdedupcache.h"
+
+namespace Bytedesk {
+
+namespace {
+
+// 两个固定种子，保证同一uid在进程内得到相同摘要
+const size_t DIGEST_SEED_HIGH = 0x9E3779B97F4A7C15ULL;
+const size_t DIGEST_SEED_LOW = 0xC2B2AE3D27D4EB4FULL;
+
+} // namespace
+
+MqttDedupCache::MqttDedupCache(int capacity)
+    : m_head(-1)
+    , m_tail(-1)
+    , m_used(0)
+    , m_hits(0)
+    , m_misses(0)
+    , m_evictions(0)
+{
+    setCapacity(capacity);
+}
+
+MqttDedupCache::Digest MqttDedupCache::digestOf(QStringView uid)
+{
+    Digest digest;
+    digest.high = qHash(uid, DIGEST_SEED_HIGH);
+    digest.low = qHash(uid, DIGEST_SEED_LOW);
+    return digest;
+}
+
+bool MqttDedupCache::insert(QStringView uid)
+{
+    const Digest digest = digestOf(uid);
+
+    auto it = m_index.constFind(digest);
+    if (it != m_index.constEnd()) {
+        const int index = it.value();
+        if (index != m_head) {
+            unlink(index);
+            pushFront(index);
+        }
+        m_hits++;
+        return false;
+    }
+
+    m_misses++;
+
+    int index;
+    if (m_used < capacity()) {
+        index = m_used++;
+    } else {
+        // 淘汰最久未使用的条目，复用其节点
+        index = m_tail;
+        m_index.remove(m_nodes[index].digest);
+        unlink(index);
+        m_evictions++;
+    }
+
+    m_nodes[index].digest = digest;
+    pushFront(index);
+    m_index.insert(digest, index);
+    return true;
+}
+
+bool MqttDedupCache::contains(QStringView uid) const
+{
+    return m_index.contains(digestOf(uid));
+}
+
+void MqttDedupCache::setCapacity(int capacity)
+{
+    m_nodes.assign(static_cast<size_t>(qMax(1, capacity)), Node());
+    clear();
+}
+
+void MqttDedupCache::clear()
+{
+    m_index.clear();
+    m_index.reserve(capacity());
+    m_head = -1;
+    m_tail = -1;
+    m_used = 0;
+}
+
+MqttDedupStats MqttDedupCache::getStats() const
+{
+    MqttDedupStats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.evictions = m_evictions;
+    stats.size = size();
+    stats.capacity = capacity();
+    return stats;
+}
+
+void MqttDedupCache::unlink(int index)
+{
+    Node& node = m_nodes[index];
+    if (node.prev >= 0) {
+        m_nodes[node.prev].next = node.next;
+    } else {
+        m_head = node.next;
+    }
+    if (node.next >= 0) {
+        m_nodes[node.next].prev = node.prev;
+    } else {
+        m_tail = node.prev;
+    }
+    node.prev = -1;
+    node.next = -1;
+}
+
+void MqttDedupCache::pushFront(int index)
+{
+    Node& node = m_nodes[index];
+    node.prev = -1;
+    node.next = m_head;
+    if (m_head >= 0) {
+        m_nodes[m_head].prev = index;
+    }
+    m_head = index;
+    if (m_tail < 0) {
+        m_tail = index;
+    }
+}
+
+} // namespace Bytedesk
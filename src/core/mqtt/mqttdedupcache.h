@@ -0,0 +1,83 @@
+#ifndef MQTTDEDUPCACHE_H
+#define MQTTDEDUPCACHE_H
+
+#include <QHash>
+#include <QStringView>
+#include <vector>
+
+namespace Bytedesk {
+
+// 去重缓存统计
+struct MqttDedupStats {
+    quint64 hits = 0;       // 判定为重复的次数
+    quint64 misses = 0;     // 首次出现的次数
+    quint64 evictions = 0;  // 因容量淘汰的条目数
+    int size = 0;
+    int capacity = 0;
+
+    double hitRate() const {
+        const quint64 total = hits + misses;
+        return total > 0 ? static_cast<double>(hits) / static_cast<double>(total) : 0.0;
+    }
+};
+
+// 固定容量的LRU去重缓存
+// 只保存uid的128位摘要（两个不同种子的64位哈希），不保存字符串本身；
+// 节点在构造时一次性分配，哈希表预留容量，满了以后淘汰最久未出现的条目并复用其节点，
+// 插入和查询都是O(1)且运行期间不再分配内存。非线程安全
+class MqttDedupCache
+{
+public:
+    explicit MqttDedupCache(int capacity = 4096);
+
+    // 首次出现时记录并返回true；已存在时刷新为最近使用并返回false
+    bool insert(QStringView uid);
+    bool contains(QStringView uid) const;
+
+    // 修改容量会清空已有条目
+    void setCapacity(int capacity);
+    int capacity() const { return static_cast<int>(m_nodes.size()); }
+    int size() const { return static_cast<int>(m_index.size()); }
+
+    void clear();
+
+    MqttDedupStats getStats() const;
+
+private:
+    struct Digest {
+        quint64 high = 0;
+        quint64 low = 0;
+
+        bool operator==(const Digest& other) const {
+            return high == other.high && low == other.low;
+        }
+        friend size_t qHash(const Digest& digest, size_t seed = 0) {
+            return static_cast<size_t>(digest.low) ^ seed;
+        }
+    };
+
+    struct Node {
+        Digest digest;
+        int prev = -1;
+        int next = -1;
+    };
+
+    static Digest digestOf(QStringView uid);
+
+    void unlink(int index);
+    void pushFront(int index);
+
+    std::vector<Node> m_nodes;
+    QHash<Digest, int> m_index;  // 摘要 -> 节点下标
+    int m_head;                  // 最近使用
+    int m_tail;                  // 最久未使用
+    int m_used;                  // 已分配出去的节点数
+
+    quint64 m_hits;
+    quint64 m_misses;
+    quint64 m_evictions;
+};
+
+} // namespace Bytedesk
+
+#endif // MQTTDEDUPCACHE_H
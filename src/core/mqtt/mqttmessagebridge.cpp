@@ -0,0 +1,98 @@
+#include "mqttmessagebridge.h"
+#include <QThread>
+#include <QDebug>
+
+namespace Bytedesk {
+
+MqttMessageBridge::MqttMessageBridge(int capacity, QObject* parent)
+    : QObject(parent)
+    , m_queue(static_cast<std::size_t>(qMax(2, capacity)))
+    , m_drainScheduled(false)
+    , m_closed(false)
+    , m_stalls(0)
+{
+    // QElapsedTimer 读取单调时钟，可在两个线程中同时调用 nsecsElapsed()
+    m_clock.start();
+}
+
+MqttMessageBridge::~MqttMessageBridge()
+{
+}
+
+void MqttMessageBridge::post(const MessagePtr& message)
+{
+    Entry entry;
+    entry.message = message;
+    entry.enqueuedNs = m_clock.nsecsElapsed();
+
+    bool stalled = false;
+    while (!m_queue.tryPush(std::move(entry))) {
+        if (m_closed.load(std::memory_order_acquire)) {
+            return;
+        }
+        if (!stalled) {
+            stalled = true;
+            m_stalls.fetch_add(1, std::memory_order_relaxed);
+            qWarning() << "MQTT bridge queue full, waiting for UI thread";
+            // 确保UI线程会来取
+            scheduleDrain();
+        }
+        QThread::yieldCurrentThread();
+    }
+
+    scheduleDrain();
+}
+
+void MqttMessageBridge::close()
+{
+    m_closed.store(true, std::memory_order_release);
+}
+
+MqttBridgeStats MqttMessageBridge::getStats() const
+{
+    MqttBridgeStats stats = m_stats;
+    stats.queueDepth = static_cast<int>(m_queue.size());
+    stats.stalls = m_stalls.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void MqttMessageBridge::scheduleDrain()
+{
+    // 已有待处理的取出请求时不再重复投递，整批消息只产生一次跨线程调用
+    if (!m_drainScheduled.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, &MqttMessageBridge::drain, Qt::QueuedConnection);
+    }
+}
+
+void MqttMessageBridge::drain()
+{
+    // 先清除标记再取数据：之后入队的消息会重新触发一次取出
+    m_drainScheduled.exchange(false, std::memory_order_acq_rel);
+
+    const int depth = static_cast<int>(m_queue.size());
+    if (depth == 0) {
+        return;
+    }
+
+    QList<MessagePtr> messages;
+    messages.reserve(depth);
+
+    const qint64 now = m_clock.nsecsElapsed();
+    Entry entry;
+    while (m_queue.tryPop(entry)) {
+        // 取出过程中新入队的消息晚于 now，按0计
+        const qint64 latencyUs = qMax<qint64>(0, (now - entry.enqueuedNs) / 1000);
+        m_stats.lastHandoffLatencyUs = latencyUs;
+        m_stats.maxHandoffLatencyUs = qMax(m_stats.maxHandoffLatencyUs, latencyUs);
+        m_stats.totalHandoffLatencyUs += latencyUs;
+        messages.append(std::move(entry.message));
+    }
+
+    m_stats.delivered += messages.size();
+    m_stats.batches++;
+    m_stats.maxQueueDepth = qMax(m_stats.maxQueueDepth, depth);
+
+    emit messagesReceived(messages);
+}
+
+} // namespace Bytedesk
@@ -0,0 +1,76 @@
+#ifndef MQTTMESSAGEBRIDGE_H
+#define MQTTMESSAGEBRIDGE_H
+
+#include <QObject>
+#include <QList>
+#include <QElapsedTimer>
+#include <atomic>
+
+#include "spscringbuffer.h"
+#include "models/message.h"
+
+namespace Bytedesk {
+
+// 网络线程 -> UI线程交接统计
+struct MqttBridgeStats {
+    int queueDepth = 0;                 // 当前队列中的消息数
+    int maxQueueDepth = 0;              // 单次取出时观察到的最大队列深度
+    quint64 delivered = 0;              // 已交给UI的消息总数
+    quint64 batches = 0;                // 批次数（每批一次信号）
+    quint64 stalls = 0;                 // 队列已满、生产者等待的次数
+    qint64 lastHandoffLatencyUs = 0;    // 入队到UI取出的延迟
+    qint64 maxHandoffLatencyUs = 0;
+    qint64 totalHandoffLatencyUs = 0;
+
+    qint64 averageHandoffLatencyUs() const {
+        return delivered > 0 ? totalHandoffLatencyUs / static_cast<qint64>(delivered) : 0;
+    }
+    double averageBatchSize() const {
+        return batches > 0 ? static_cast<double>(delivered) / static_cast<double>(batches) : 0.0;
+    }
+};
+
+// 把网络线程解码出的消息批量交给UI线程
+// 网络线程调用 post() 写入有界SPSC环形缓冲区，每批只投递一次排队调用；
+// UI线程在 drain() 中一次性取出所有消息并发出 messagesReceived
+class MqttMessageBridge : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MqttMessageBridge(int capacity = 4096, QObject* parent = nullptr);
+    ~MqttMessageBridge();
+
+    // 网络线程调用；队列已满时让出CPU等待UI线程取走消息（对TCP形成背压）
+    void post(const MessagePtr& message);
+
+    // 关闭后 post() 不再等待，直接丢弃（退出时避免与UI线程互相等待）
+    void close();
+
+    MqttBridgeStats getStats() const;
+
+signals:
+    void messagesReceived(const QList<MessagePtr>& messages);
+
+private:
+    void scheduleDrain();
+    void drain();
+
+    struct Entry {
+        MessagePtr message;
+        qint64 enqueuedNs = 0;
+    };
+
+    SpscRingBuffer<Entry> m_queue;
+    QElapsedTimer m_clock;
+    std::atomic<bool> m_drainScheduled;
+    std::atomic<bool> m_closed;
+    std::atomic<quint64> m_stalls;
+
+    // 以下只在UI线程访问
+    MqttBridgeStats m_stats;
+};
+
+} // namespace Bytedesk
+
+#endif // MQTTMESSAGEBRIDGE_H
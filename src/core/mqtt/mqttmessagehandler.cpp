@@ -1,8 +1,11 @@
 #include "mqttmessagehandler.h"
+#include "mqttmessagebridge.h"
 #include <QJsonObject>
+#include <QJsonArray>
 #include <QJsonDocument>
-#include <QUuid>
+#include <QThread>
 #include <QDebug>
+#include <utility>
 
 namespace Bytedesk {
 
@@ -26,21 +29,46 @@ const QString MqttMessageHandler::TOPIC_ORG_GROUP_PREFIX = "org/group/";
 const QString MqttMessageHandler::TOPIC_ORG_MEMBER_PREFIX = "org/member/";
 const QString MqttMessageHandler::TOPIC_QUEUE_PREFIX = "org/queue/";
 
+const QString MqttMessageHandler::EXTRA_READ_UP_TO = "readUpTo";
+const QString MqttMessageHandler::EXTRA_TYPING = "typing";
+
 MqttMessageHandler::MqttMessageHandler(MqttClient* mqttClient, QObject* parent)
     : QObject(parent)
     , m_mqttClient(mqttClient)
+    , m_bridge(nullptr)
+    , m_wireFormat(MqttWireFormat::JSON)
+    , m_batchEnvelopeEnabled(false)
+    , m_readWatermarkTimer(new QTimer(this))
+    , m_typingEngine(new MqttTypingEngine(this))
+    , m_decodePipeline(nullptr)
 {
     Q_ASSERT(mqttClient);
 
+    m_readWatermarkTimer->setSingleShot(true);
+    m_readWatermarkTimer->setInterval(500);
+    connect(m_readWatermarkTimer, &QTimer::timeout,
+            this, &MqttMessageHandler::flushReadWatermarks);
+
+    connect(m_typingEngine, &MqttTypingEngine::publishTyping,
+            this, &MqttMessageHandler::onPublishTyping);
+    connect(m_typingEngine, &MqttTypingEngine::typingStateChanged,
+            this, &MqttMessageHandler::typingStateChanged);
+
     // 连接MQTT客户端信号
     connect(mqttClient, &MqttClient::messageReceived,
             this, &MqttMessageHandler::onMqttMessageReceived);
+    connect(mqttClient, &MqttClient::readBatchFinished,
+            this, &MqttMessageHandler::onMqttReadBatchFinished);
     connect(mqttClient, &MqttClient::connected,
             this, &MqttMessageHandler::onMqttConnected);
     connect(mqttClient, &MqttClient::disconnected,
             this, &MqttMessageHandler::onMqttDisconnected);
     connect(mqttClient, &MqttClient::errorOccurred,
             this, &MqttMessageHandler::onMqttError);
+    connect(mqttClient, &MqttClient::publishAcknowledged,
+            this, &MqttMessageHandler::onMqttPublishAcknowledged);
+    connect(mqttClient, &MqttClient::publishDropped,
+            this, &MqttMessageHandler::onMqttPublishDropped);
 }
 
 MqttMessageHandler::~MqttMessageHandler()
@@ -53,58 +81,314 @@ void MqttMessageHandler::init()
     qDebug() << "MqttMessageHandler initialized";
 }
 
+void MqttMessageHandler::setMessageBridge(MqttMessageBridge* bridge)
+{
+    m_bridge = bridge;
+}
+
+void MqttMessageHandler::setDedupCapacity(int capacity)
+{
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { setDedupCapacity(capacity); }, Qt::QueuedConnection);
+        return;
+    }
+
+    m_inboundDedup.setCapacity(capacity);
+    m_sentReadDedup.setCapacity(capacity);
+    m_sentDeliveredDedup.setCapacity(capacity);
+}
+
+void MqttMessageHandler::markMessageSeen(const QString& messageUid)
+{
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { markMessageSeen(messageUid); }, Qt::QueuedConnection);
+        return;
+    }
+
+    m_inboundDedup.insert(messageUid);
+}
+
+void MqttMessageHandler::setDecodeParallelism(int parallelism)
+{
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { setDecodeParallelism(parallelism); }, Qt::QueuedConnection);
+        return;
+    }
+
+    if (parallelism < 0) {
+        parallelism = QThread::idealThreadCount();
+    }
+
+    if (m_decodePipeline && m_decodePipeline->parallelism() == parallelism) {
+        return;
+    }
+
+    // 在途载荷可能已经确认给broker，先解码交付完再替换流水线
+    // drain() 会同步分发消息，不能持有 m_mutex；统计读取方只在替换指针时加锁
+    if (m_decodePipeline) {
+        m_decodePipeline->drain();
+    }
+
+    MqttDecodePipeline* pipeline = nullptr;
+    if (parallelism != 0) {
+        pipeline = new MqttDecodePipeline(parallelism, &MqttMessageHandler::decodePayload, this);
+        connect(pipeline, &MqttDecodePipeline::decoded,
+                this, &MqttMessageHandler::onPipelineDecoded);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_decodePipeline) {
+        m_retiredDecodeStats.merge(m_decodePipeline->getStats().decoder);
+        delete m_decodePipeline;
+    }
+    m_decodePipeline = pipeline;
+}
+
+ProtobufDecodeStats MqttMessageHandler::getDecodeStats() const
+{
+    // 同步路径解码器的快照 + 当前和已替换的流水线工作线程解码器
+    QMutexLocker locker(&m_mutex);
+    ProtobufDecodeStats stats = m_decodeStats;
+    stats.merge(m_retiredDecodeStats);
+    if (m_decodePipeline) {
+        stats.merge(m_decodePipeline->getStats().decoder);
+    }
+    return stats;
+}
+
+MqttDecodeStats MqttMessageHandler::getPipelineStats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_decodePipeline ? m_decodePipeline->getStats() : MqttDecodeStats();
+}
+
+void MqttMessageHandler::setTypingTimeouts(int sendInterval, int idleTimeout, int expiry)
+{
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { setTypingTimeouts(sendInterval, idleTimeout, expiry); }, Qt::QueuedConnection);
+        return;
+    }
+
+    m_typingEngine->setSendInterval(sendInterval);
+    m_typingEngine->setIdleTimeout(idleTimeout);
+    m_typingEngine->setExpiry(expiry);
+}
+
+void MqttMessageHandler::setReadWatermarkWindow(int milliseconds)
+{
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { setReadWatermarkWindow(milliseconds); }, Qt::QueuedConnection);
+        return;
+    }
+
+    m_readWatermarkTimer->setInterval(qMax(0, milliseconds));
+}
+
+QDateTime MqttMessageHandler::getPeerReadWatermark(const QString& threadUid) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_peerReadWatermarks.value(threadUid);
+}
+
+bool MqttMessageHandler::isReadByPeer(const MessagePtr& message) const
+{
+    const QDateTime watermark = getPeerReadWatermark(message->getThreadUid());
+    return watermark.isValid() && message->getCreatedAt() <= watermark;
+}
+
+void MqttMessageHandler::setWireFormat(MqttWireFormat format)
+{
+    if (format == MqttWireFormat::PROTOBUF && !ProtobufWrapper::isAvailable()) {
+        qWarning() << "Protobuf support not compiled in, keeping JSON wire format";
+        format = MqttWireFormat::JSON;
+    }
+    m_wireFormat = format;
+}
+
+bool MqttMessageHandler::isOtherThread() const
+{
+    return QThread::currentThread() != QObject::thread();
+}
+
+void MqttMessageHandler::deliverMessage(const MessagePtr& message)
+{
+    if (m_bridge) {
+        m_bridge->post(message);
+    } else {
+        emit messageReceived(message);
+    }
+}
+
+void MqttMessageHandler::deliverMessages(const QList<MessagePtr>& messages)
+{
+    if (messages.isEmpty()) {
+        return;
+    }
+
+    if (m_bridge) {
+        // 桥接器本身按批交付给UI线程
+        for (const MessagePtr& message : messages) {
+            m_bridge->post(message);
+        }
+    } else {
+        emit messagesReceived(messages);
+    }
+}
+
 void MqttMessageHandler::subscribeToThread(const QString& threadUid, const QString& topic)
 {
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { subscribeToThread(threadUid, topic); }, Qt::QueuedConnection);
+        return;
+    }
+
     QMutexLocker locker(&m_mutex);
 
     m_threadTopics[threadUid] = topic;
-    m_topicThreads[topic] = threadUid;
+    m_topicRoutes.insert(topic, {topicKind(topic), threadUid});
 
-    if (m_mqttClient->isConnected()) {
-        m_mqttClient->subscribe(topic, 0);
-        qDebug() << "Subscribed to thread:" << threadUid << "topic:" << topic;
+    // 已被通配符订阅覆盖的主题只登记路由，不再单独订阅
+    if (m_wildcardFilters.contains(topic)) {
+        qDebug() << "Thread topic covered by wildcard:" << threadUid << "topic:" << topic;
+        return;
     }
+
+    // MqttClient负责记录订阅、合并发送以及重连后的恢复，这里不再重复订阅
+    m_mqttClient->subscribe(topic, 0);
+    qDebug() << "Subscribed to thread:" << threadUid << "topic:" << topic;
 }
 
 void MqttMessageHandler::unsubscribeFromThread(const QString& threadUid)
 {
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { unsubscribeFromThread(threadUid); }, Qt::QueuedConnection);
+        return;
+    }
+
     QMutexLocker locker(&m_mutex);
 
     if (m_threadTopics.contains(threadUid)) {
         QString topic = m_threadTopics.take(threadUid);
-        m_topicThreads.remove(topic);
+        m_topicRoutes.remove(topic);
 
-        if (m_mqttClient->isConnected()) {
+        if (!m_wildcardFilters.contains(topic)) {
             m_mqttClient->unsubscribe(topic);
-            qDebug() << "Unsubscribed from thread:" << threadUid;
         }
+        qDebug() << "Unsubscribed from thread:" << threadUid;
     }
 }
 
 void MqttMessageHandler::subscribeToQueue(const QString& agentUid)
 {
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { subscribeToQueue(agentUid); }, Qt::QueuedConnection);
+        return;
+    }
+
     QString topic = TOPIC_QUEUE_PREFIX + agentUid;
 
-    if (m_mqttClient->isConnected()) {
-        m_mqttClient->subscribe(topic, 0);
-        qDebug() << "Subscribed to queue:" << topic;
+    if (!m_queueTopic.isEmpty() && m_queueTopic != topic) {
+        m_topicRoutes.remove(m_queueTopic);
+        m_mqttClient->unsubscribe(m_queueTopic);
     }
+
+    m_queueTopic = topic;
+    m_topicRoutes.insert(topic, {MqttTopicKind::QUEUE, QString()});
+    m_mqttClient->subscribe(topic, 0);
+    qDebug() << "Subscribed to queue:" << topic;
 }
 
 void MqttMessageHandler::unsubscribeFromQueue()
 {
-    // TODO: 实现取消订阅队列
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, &MqttMessageHandler::unsubscribeFromQueue, Qt::QueuedConnection);
+        return;
+    }
+
+    if (m_queueTopic.isEmpty()) {
+        return;
+    }
+
+    m_topicRoutes.remove(m_queueTopic);
+    m_mqttClient->unsubscribe(m_queueTopic);
+    qDebug() << "Unsubscribed from queue:" << m_queueTopic;
+    m_queueTopic.clear();
+}
+
+void MqttMessageHandler::subscribeToFilter(const QString& filter)
+{
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { subscribeToFilter(filter); }, Qt::QueuedConnection);
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    const MqttTopicRoute route{topicKind(filter), QString()};
+    m_wildcardFilters.insert(filter, route);
+    m_topicRoutes.insert(filter, route);
+    m_mqttClient->subscribe(filter, 0);
+
+    // 已被覆盖的精确订阅可以取消，避免broker重复投递
+    for (auto it = m_threadTopics.cbegin(); it != m_threadTopics.cend(); ++it) {
+        if (m_wildcardFilters.contains(it.value())) {
+            m_mqttClient->unsubscribe(it.value());
+        }
+    }
+
+    qDebug() << "Subscribed to filter:" << filter;
+}
+
+void MqttMessageHandler::unsubscribeFromFilter(const QString& filter)
+{
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { unsubscribeFromFilter(filter); }, Qt::QueuedConnection);
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_wildcardFilters.remove(filter)) {
+        return;
+    }
+    m_topicRoutes.remove(filter);
+    m_mqttClient->unsubscribe(filter);
+
+    // 不再被覆盖的会话主题恢复精确订阅
+    for (auto it = m_threadTopics.cbegin(); it != m_threadTopics.cend(); ++it) {
+        if (!m_wildcardFilters.contains(it.value())) {
+            m_mqttClient->subscribe(it.value(), 0);
+        }
+    }
+
+    qDebug() << "Unsubscribed from filter:" << filter;
+}
+
+MqttTopicKind MqttMessageHandler::topicKind(QStringView topic)
+{
+    if (topic.startsWith(TOPIC_ORG_AGENT_PREFIX)) return MqttTopicKind::AGENT;
+    if (topic.startsWith(TOPIC_ORG_WORKGROUP_PREFIX)) return MqttTopicKind::WORKGROUP;
+    if (topic.startsWith(TOPIC_ORG_ROBOT_PREFIX)) return MqttTopicKind::ROBOT;
+    if (topic.startsWith(TOPIC_ORG_GROUP_PREFIX)) return MqttTopicKind::GROUP;
+    if (topic.startsWith(TOPIC_ORG_MEMBER_PREFIX)) return MqttTopicKind::MEMBER;
+    if (topic.startsWith(TOPIC_QUEUE_PREFIX)) return MqttTopicKind::QUEUE;
+    return MqttTopicKind::UNKNOWN;
 }
 
 void MqttMessageHandler::sendTextMessage(const ThreadPtr& thread, const QString& text, const UserPtr& user)
 {
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { sendTextMessage(thread, text, user); }, Qt::QueuedConnection);
+        return;
+    }
+
     if (!thread || !user) {
         qWarning() << "Invalid thread or user for text message";
         return;
     }
 
     MessagePtr message = QSharedPointer<Message>::create();
-    message->setUid(generateMessageUid());
+    message->setUid(Message::generateUid());
     message->setType(MessageType::TEXT);
     message->setContent(text);
     message->setThreadUid(thread->getUid());
@@ -113,28 +397,25 @@ void MqttMessageHandler::sendTextMessage(const ThreadPtr& thread, const QString&
     message->setUserAvatar(user->getAvatar());
     message->setStatus(MessageStatus::SENDING);
 
-    QByteArray data = serializeMessage(*message);
+    publishMessage(thread, message);
+    qDebug() << "Sent text message:" << message->getUid();
 
-    if (m_mqttClient->isConnected() && !thread->getTopic().isEmpty()) {
-        m_mqttClient->publish(thread->getTopic(), data, 0, false);
-        message->setStatus(MessageStatus::SENT);
-        qDebug() << "Sent text message:" << message->getUid();
-    } else {
-        qWarning() << "MQTT not connected or topic is empty";
-        message->setStatus(MessageStatus::FAILED);
-    }
-
-    emit messageReceived(message);
+    deliverMessage(message);
 }
 
 void MqttMessageHandler::sendImageMessage(const ThreadPtr& thread, const QString& imageUrl, const UserPtr& user)
 {
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { sendImageMessage(thread, imageUrl, user); }, Qt::QueuedConnection);
+        return;
+    }
+
     if (!thread || !user) {
         return;
     }
 
     MessagePtr message = QSharedPointer<Message>::create();
-    message->setUid(generateMessageUid());
+    message->setUid(Message::generateUid());
     message->setType(MessageType::IMAGE);
 
     MessageContent content;
@@ -147,26 +428,26 @@ void MqttMessageHandler::sendImageMessage(const ThreadPtr& thread, const QString
     message->setUserAvatar(user->getAvatar());
     message->setStatus(MessageStatus::SENDING);
 
-    QByteArray data = serializeMessage(*message);
-
-    if (m_mqttClient->isConnected() && !thread->getTopic().isEmpty()) {
-        m_mqttClient->publish(thread->getTopic(), data, 0, false);
-        message->setStatus(MessageStatus::SENT);
-        qDebug() << "Sent image message:" << message->getUid();
-    }
+    publishMessage(thread, message);
+    qDebug() << "Sent image message:" << message->getUid();
 
-    emit messageReceived(message);
+    deliverMessage(message);
 }
 
 void MqttMessageHandler::sendFileMessage(const ThreadPtr& thread, const QString& fileUrl,
                                         const QString& fileName, qint64 fileSize, const UserPtr& user)
 {
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { sendFileMessage(thread, fileUrl, fileName, fileSize, user); }, Qt::QueuedConnection);
+        return;
+    }
+
     if (!thread || !user) {
         return;
     }
 
     MessagePtr message = QSharedPointer<Message>::create();
-    message->setUid(generateMessageUid());
+    message->setUid(Message::generateUid());
     message->setType(MessageType::FILE);
 
     MessageContent content;
@@ -181,77 +462,141 @@ void MqttMessageHandler::sendFileMessage(const ThreadPtr& thread, const QString&
     message->setUserAvatar(user->getAvatar());
     message->setStatus(MessageStatus::SENDING);
 
-    QByteArray data = serializeMessage(*message);
+    publishMessage(thread, message);
 
-    if (m_mqttClient->isConnected() && !thread->getTopic().isEmpty()) {
-        m_mqttClient->publish(thread->getTopic(), data, 0, false);
-        message->setStatus(MessageStatus::SENT);
+    deliverMessage(message);
+}
+
+void MqttMessageHandler::sendTypingMessage(const ThreadPtr& thread, const UserPtr& user)
+{
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { sendTypingMessage(thread, user); }, Qt::QueuedConnection);
+        return;
     }
 
-    emit messageReceived(message);
+    m_typingEngine->localTyping(thread, user);
 }
 
-void MqttMessageHandler::sendTypingMessage(const ThreadPtr& thread, const UserPtr& user)
+void MqttMessageHandler::onPublishTyping(const ThreadPtr& thread, const UserPtr& user, bool typing)
 {
-    if (!thread || !user) {
+    if (!m_mqttClient->isConnected() || thread->getTopic().isEmpty()) {
         return;
     }
 
     MessagePtr message = QSharedPointer<Message>::create();
-    message->setUid(generateMessageUid());
+    message->setUid(Message::generateUid());
     message->setType(MessageType::TYPING);
     message->setThreadUid(thread->getUid());
     message->setUserUid(user->getUid());
+    if (!typing) {
+        message->setExtra(QJsonObject{{EXTRA_TYPING, false}});
+    }
 
-    QByteArray data = serializeMessage(*message);
+    // broker回送的自己的输入状态不处理
+    m_inboundDedup.insert(message->getUid());
 
-    if (m_mqttClient->isConnected() && !thread->getTopic().isEmpty()) {
-        m_mqttClient->publish(thread->getTopic(), data, 0, false);
+    m_mqttClient->publish(thread->getTopic(), serializeMessage(*message), 0, false);
+}
+
+void MqttMessageHandler::sendReadReceipt(const ThreadPtr& thread, const QString& messageUid, const UserPtr& user,
+                                         const QDateTime& createdAt)
+{
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { sendReadReceipt(thread, messageUid, user, createdAt); }, Qt::QueuedConnection);
+        return;
+    }
+
+    if (!thread || !user || messageUid.isEmpty()) {
+        return;
+    }
+
+    const QString threadUid = thread->getUid();
+    const QDateTime readUpTo = createdAt.isValid() ? createdAt : QDateTime::currentDateTimeUtc();
+
+    // 水位只前进：不晚于已发送水位的已读直接忽略
+    const QDateTime sent = m_sentReadWatermarks.value(threadUid);
+    if (sent.isValid() && readUpTo <= sent) {
+        return;
+    }
+
+    auto it = m_pendingReadWatermarks.find(threadUid);
+    if (it == m_pendingReadWatermarks.end()) {
+        m_pendingReadWatermarks.insert(threadUid, {thread, user, messageUid, readUpTo});
+    } else if (readUpTo >= it->readUpTo) {
+        *it = {thread, user, messageUid, readUpTo};
+    }
+
+    if (!m_readWatermarkTimer->isActive()) {
+        m_readWatermarkTimer->start();
     }
 }
 
-void MqttMessageHandler::sendReadReceipt(const ThreadPtr& thread, const QString& messageUid, const UserPtr& user)
+void MqttMessageHandler::flushReadWatermarks()
 {
-    if (!thread || !user) {
+    if (m_pendingReadWatermarks.isEmpty()) {
         return;
     }
 
-    // 防止重复发送
-    if (m_sentReadUids.contains(messageUid)) {
+    // 未连接时水位保持待发送，重连后由 onMqttConnected 补发
+    if (!m_mqttClient->isConnected()) {
+        qDebug() << "MQTT not connected, keeping" << m_pendingReadWatermarks.size() << "read watermarks pending";
         return;
     }
 
-    addToSentMessages(messageUid);
+    const QHash<QString, ReadWatermark> pending = std::exchange(m_pendingReadWatermarks, {});
 
-    MessagePtr message = QSharedPointer<Message>::create();
-    message->setUid(generateMessageUid());
-    message->setType(MessageType::READ);
-    message->setContent(messageUid); // 读取的消息UID
-    message->setThreadUid(thread->getUid());
-    message->setUserUid(user->getUid());
+    for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+        const ReadWatermark& watermark = it.value();
 
-    QByteArray data = serializeMessage(*message);
+        if (watermark.thread->getTopic().isEmpty()) {
+            qWarning() << "Read watermark dropped, thread has no topic:" << it.key();
+            continue;
+        }
 
-    if (m_mqttClient->isConnected() && !thread->getTopic().isEmpty()) {
-        m_mqttClient->publish(thread->getTopic(), data, 0, false);
-        qDebug() << "Sent read receipt for:" << messageUid;
+        // 防止重复发送；此时已确认连接可用，随后就会发出，insert 同时计入命中统计
+        if (!m_sentReadDedup.insert(watermark.messageUid)) {
+            continue;
+        }
+
+        MessagePtr message = QSharedPointer<Message>::create();
+        message->setUid(Message::generateUid());
+        message->setType(MessageType::READ);
+        message->setContent(watermark.messageUid); // 水位所在的消息UID
+        message->setThreadUid(it.key());
+        message->setUserUid(watermark.user->getUid());
+
+        message->setExtra(QJsonObject{{EXTRA_READ_UP_TO, watermark.readUpTo.toString(Qt::ISODateWithMs)}});
+
+        // broker回送的自己的回执不当作对方的水位
+        m_inboundDedup.insert(message->getUid());
+
+        m_mqttClient->publish(watermark.thread->getTopic(), serializeMessage(*message), 0, false);
+        qDebug() << "Sent read watermark:" << it.key() << "up to:" << watermark.messageUid;
+
+        // 发出后才记录已发送水位
+        m_sentReadWatermarks.insert(it.key(), watermark.readUpTo);
+
+        emit readWatermarkFlushed(it.key(), watermark.messageUid, watermark.readUpTo);
     }
 }
 
 void MqttMessageHandler::sendDeliveredReceipt(const ThreadPtr& thread, const QString& messageUid, const UserPtr& user)
 {
-    if (!thread || !user) {
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { sendDeliveredReceipt(thread, messageUid, user); }, Qt::QueuedConnection);
         return;
     }
 
-    if (m_sentDeliveredUids.contains(messageUid)) {
+    if (!thread || !user) {
         return;
     }
 
-    addToSentMessages(messageUid);
+    if (!m_sentDeliveredDedup.insert(messageUid)) {
+        return;
+    }
 
     MessagePtr message = QSharedPointer<Message>::create();
-    message->setUid(generateMessageUid());
+    message->setUid(Message::generateUid());
     message->setType(MessageType::DELIVERED);
     message->setContent(messageUid);
     message->setThreadUid(thread->getUid());
@@ -264,17 +609,225 @@ void MqttMessageHandler::sendDeliveredReceipt(const ThreadPtr& thread, const QSt
     }
 }
 
+void MqttMessageHandler::sendMessages(const ThreadPtr& thread, const QList<MessagePtr>& messages)
+{
+    if (isOtherThread()) {
+        // 在调用方线程复制：调用方保留原对象，网络线程修改并交付的是副本，两边不共享可变的Message
+        QList<MessagePtr> copies;
+        copies.reserve(messages.size());
+        for (const MessagePtr& message : messages) {
+            if (message) {
+                copies.append(QSharedPointer<Message>::create(*message));
+            }
+        }
+        QMetaObject::invokeMethod(this, [=]() { sendMessages(thread, copies); }, Qt::QueuedConnection);
+        return;
+    }
+
+    if (!thread || messages.isEmpty()) {
+        return;
+    }
+
+    for (const MessagePtr& message : messages) {
+        if (message->getThreadUid().isEmpty()) {
+            message->setThreadUid(thread->getUid());
+        }
+        message->setStatus(MessageStatus::SENDING);
+    }
+
+    publishMessages(thread->getTopic(), messages);
+    qDebug() << "Sent message batch:" << messages.size() << "thread:" << thread->getUid();
+
+    deliverMessages(messages);
+}
+
+void MqttMessageHandler::sendTextMessages(const QList<ThreadPtr>& threads, const QString& text, const UserPtr& user)
+{
+    if (isOtherThread()) {
+        QMetaObject::invokeMethod(this, [=]() { sendTextMessages(threads, text, user); }, Qt::QueuedConnection);
+        return;
+    }
+
+    if (!user) {
+        qWarning() << "Invalid user for text messages";
+        return;
+    }
+
+    // 按主题分组，保持会话的原始顺序
+    QStringList topics;
+    QHash<QString, QList<MessagePtr>> messagesByTopic;
+    QList<MessagePtr> messages;
+    messages.reserve(threads.size());
+
+    for (const ThreadPtr& thread : threads) {
+        if (!thread) {
+            continue;
+        }
+
+        MessagePtr message = QSharedPointer<Message>::create();
+        message->setUid(Message::generateUid());
+        message->setType(MessageType::TEXT);
+        message->setContent(text);
+        message->setThreadUid(thread->getUid());
+        message->setUserUid(user->getUid());
+        message->setUserName(user->getNickname());
+        message->setUserAvatar(user->getAvatar());
+        message->setStatus(MessageStatus::SENDING);
+
+        const QString topic = thread->getTopic();
+        if (!messagesByTopic.contains(topic)) {
+            topics.append(topic);
+        }
+        messagesByTopic[topic].append(message);
+        messages.append(message);
+    }
+
+    for (const QString& topic : topics) {
+        publishMessages(topic, messagesByTopic.value(topic));
+    }
+    qDebug() << "Sent text to" << messages.size() << "threads over" << topics.size() << "topics";
+
+    deliverMessages(messages);
+}
+
+void MqttMessageHandler::publishMessage(const ThreadPtr& thread, const MessagePtr& message)
+{
+    publishMessages(thread->getTopic(), {message});
+}
+
+void MqttMessageHandler::publishMessages(const QString& topic, const QList<MessagePtr>& messages)
+{
+    // 本地已经交付，broker回送的同一条消息不再重复交付；发出消息后本地输入状态结束
+    for (const MessagePtr& message : messages) {
+        m_inboundDedup.insert(message->getUid());
+        m_typingEngine->localStopped(message->getThreadUid());
+    }
+
+    if (!m_mqttClient->isConnected() || topic.isEmpty()) {
+        qWarning() << "MQTT not connected or topic is empty";
+        for (const MessagePtr& message : messages) {
+            message->setStatus(MessageStatus::FAILED);
+        }
+        return;
+    }
+
+    // 未启用信封时每条消息单独一个PUBLISH
+    const int chunkSize = m_batchEnvelopeEnabled ? MAX_BATCH_MESSAGES : 1;
+    for (qsizetype i = 0; i < messages.size(); i += chunkSize) {
+        const QList<MessagePtr> chunk = messages.mid(i, chunkSize);
+
+        // 只有一条消息时仍使用普通格式，不识别信封的接收方也能处理
+        QByteArray data = chunk.size() == 1 ? serializeMessage(*chunk.first())
+                                            : serializeMessages(chunk);
+
+        // 聊天消息使用QoS 1，收到PUBACK后才标记为已发送
+        quint16 packetId = m_mqttClient->publish(topic, data, 1, false);
+        if (packetId == 0) {
+            for (const MessagePtr& message : chunk) {
+                message->setStatus(MessageStatus::FAILED);
+            }
+            continue;
+        }
+
+        // 消息随后交付给UI，这里只记UID，确认后按值通知状态
+        QStringList messageUids;
+        messageUids.reserve(chunk.size());
+        for (const MessagePtr& message : chunk) {
+            messageUids.append(message->getUid());
+        }
+        m_pendingAcks.insert(packetId, messageUids);
+    }
+}
+
 QByteArray MqttMessageHandler::serializeMessage(const Message& message)
 {
-    // 如果使用Protobuf，这里调用Protobuf序列化
-    // 目前使用JSON作为示例
+    if (m_wireFormat == MqttWireFormat::PROTOBUF) {
+        QByteArray data = ProtobufWrapper::serializeMessage(message);
+        if (!data.isEmpty()) {
+            return data;
+        }
+    }
+
     QJsonObject json = message.toJson();
     return QJsonDocument(json).toJson(QJsonDocument::Compact);
 }
 
+QByteArray MqttMessageHandler::serializeMessages(const QList<MessagePtr>& messages)
+{
+    if (m_wireFormat == MqttWireFormat::PROTOBUF) {
+        QByteArray data = ProtobufWrapper::serializeMessageBatch(messages);
+        if (!data.isEmpty()) {
+            return data;
+        }
+    }
+
+    QJsonArray array;
+    for (const MessagePtr& message : messages) {
+        array.append(message->toJson());
+    }
+    return QJsonDocument(array).toJson(QJsonDocument::Compact);
+}
+
+QList<MessagePtr> MqttMessageHandler::deserializeMessages(const QByteArray& data)
+{
+    return decodeMessages(data, m_protobufDecoder);
+}
+
 MessagePtr MqttMessageHandler::deserializeMessage(const QByteArray& data)
 {
-    // 如果使用Protobuf，这里调用Protobuf反序列化
+    return decodeMessage(data, m_protobufDecoder);
+}
+
+QList<MessagePtr> MqttMessageHandler::decodePayload(const QByteArray& payload, ProtobufDecoder& decoder)
+{
+    if (ProtobufWrapper::isMessageBatch(payload)) {
+        return decodeMessages(payload, decoder);
+    }
+
+    MessagePtr message = decodeMessage(payload, decoder);
+    if (message->isNull()) {
+        qWarning() << "Failed to deserialize message";
+        return QList<MessagePtr>();
+    }
+    return QList<MessagePtr>{message};
+}
+
+QList<MessagePtr> MqttMessageHandler::decodeMessages(const QByteArray& data, ProtobufDecoder& decoder)
+{
+    QList<MessagePtr> messages;
+
+    if (ProtobufWrapper::isAvailable() && !ProtobufWrapper::looksLikeJson(data)) {
+        decoder.decodeBatch(data, messages);
+        return messages;
+    }
+
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(data, &error);
+
+    if (error.error != QJsonParseError::NoError || !doc.isArray()) {
+        qWarning() << "Failed to parse message batch:" << error.errorString();
+        return messages;
+    }
+
+    const QJsonArray array = doc.array();
+    messages.reserve(array.size());
+    for (const QJsonValue& value : array) {
+        messages.append(QSharedPointer<Message>::create(Message::fromJson(value.toObject())));
+    }
+    return messages;
+}
+
+MessagePtr MqttMessageHandler::decodeMessage(const QByteArray& data, ProtobufDecoder& decoder)
+{
+    // 非JSON载荷按Protobuf解码
+    if (ProtobufWrapper::isAvailable() && !ProtobufWrapper::looksLikeJson(data)) {
+        MessagePtr message = QSharedPointer<Message>::create();
+        if (!decoder.decode(data, *message)) {
+            return QSharedPointer<Message>::create();
+        }
+        return message;
+    }
+
     QJsonParseError error;
     QJsonDocument doc = QJsonDocument::fromJson(data, &error);
 
@@ -292,12 +845,58 @@ void MqttMessageHandler::onMqttMessageReceived(const QString& topic, const QByte
 {
     qDebug() << "MQTT message received, topic:" << topic << "size:" << payload.size();
 
+    // 通过主题树定位会话和处理方式（O(主题层级)，不分配内存）
+    MqttTopicRoute route;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (const MqttTopicRoute* matched = m_topicRoutes.match(topic)) {
+            route = *matched;
+        }
+    }
+
+    // 并行解码：同一会话按提交顺序交付；通配符主题没有会话信息时按主题排序
+    if (m_decodePipeline) {
+        m_decodePipeline->submit(route.threadUid.isEmpty() ? topic : route.threadUid,
+                                 topic, route, payload);
+        return;
+    }
+
+    // 批量信封：解包后逐条分发，聊天消息整批交付一次
+    if (ProtobufWrapper::isMessageBatch(payload)) {
+        const QList<MessagePtr> messages = deserializeMessages(payload);
+        QList<MessagePtr> chatMessages;
+        chatMessages.reserve(messages.size());
+        for (const MessagePtr& message : messages) {
+            if (!message->isNull()) {
+                dispatchMessage(message, route, &chatMessages);
+            }
+        }
+        qDebug() << "Unpacked message batch:" << messages.size() << "messages";
+        deliverMessages(chatMessages);
+        return;
+    }
+
     MessagePtr message = deserializeMessage(payload);
     if (message->isNull()) {
         qWarning() << "Failed to deserialize message";
         return;
     }
 
+    dispatchMessage(message, route);
+}
+
+void MqttMessageHandler::dispatchMessage(const MessagePtr& message, const MqttTopicRoute& route,
+                                         QList<MessagePtr>* chatMessages)
+{
+    if (!m_inboundDedup.insert(message->getUid())) {
+        qDebug() << "Duplicate message dropped:" << message->getUid();
+        return;
+    }
+
+    if (message->getThreadUid().isEmpty() && !route.threadUid.isEmpty()) {
+        message->setThreadUid(route.threadUid);
+    }
+
     // 根据消息类型处理
     switch (message->getType()) {
         case MessageType::TYPING:
@@ -311,21 +910,53 @@ void MqttMessageHandler::onMqttMessageReceived(const QString& topic, const QByte
             handleNoticeMessage(message);
             break;
         default:
-            handleMessage(message);
+            // 对方发出消息即结束输入状态
+            m_typingEngine->remoteTyping(message->getThreadUid(), message->getUserUid(), false);
+            if (route.kind == MqttTopicKind::QUEUE) {
+                handleQueueMessage(message);
+            } else if (chatMessages) {
+                chatMessages->append(message);
+            } else {
+                handleMessage(message);
+            }
             break;
     }
 }
 
-void MqttMessageHandler::onMqttConnected()
+void MqttMessageHandler::onPipelineDecoded(const QList<MqttDecodedPayload>& batch)
 {
-    qDebug() << "MQTT connected, resubscribing to threads";
+    // 整批聊天消息只交付一次
+    QList<MessagePtr> chatMessages;
+    for (const MqttDecodedPayload& payload : batch) {
+        for (const MessagePtr& message : payload.messages) {
+            if (!message->isNull()) {
+                dispatchMessage(message, payload.route, &chatMessages);
+            }
+        }
+    }
+    deliverMessages(chatMessages);
+}
 
-    // 重新订阅所有主题
-    QMutexLocker locker(&m_mutex);
-    for (const QString& topic : m_threadTopics) {
-        m_mqttClient->subscribe(topic, 0);
-        qDebug() << "Resubscribed to:" << topic;
+void MqttMessageHandler::onMqttReadBatchFinished()
+{
+    // 并行解码时由流水线的工作任务在排空队列后各自回收
+    if (m_decodePipeline) {
+        return;
     }
+    m_protobufDecoder.reset();
+
+    // 解码器只在本线程使用，统计读取方（可能在其他线程）读快照
+    QMutexLocker locker(&m_mutex);
+    m_decodeStats = m_protobufDecoder.getStats();
+}
+
+void MqttMessageHandler::onMqttConnected()
+{
+    // 订阅由MqttClient在CONNACK时批量恢复，这里无需重复订阅
+    qDebug() << "MQTT connected, subscriptions restored by client";
+
+    // 断线期间积压的已读水位
+    flushReadWatermarks();
 }
 
 void MqttMessageHandler::onMqttDisconnected()
@@ -338,55 +969,125 @@ void MqttMessageHandler::onMqttError(const QString& error)
     qWarning() << "MQTT error:" << error;
 }
 
+void MqttMessageHandler::onMqttPublishAcknowledged(quint16 packetId, qint64 latencyMs)
+{
+    const QStringList messageUids = m_pendingAcks.take(packetId);
+    for (const QString& messageUid : messageUids) {
+        qDebug() << "Message acknowledged:" << messageUid << "latency:" << latencyMs << "ms";
+        emit messageStatusChanged(messageUid, MessageStatus::SENT);
+    }
+}
+
+void MqttMessageHandler::onMqttPublishDropped(quint16 packetId)
+{
+    const QStringList messageUids = m_pendingAcks.take(packetId);
+    for (const QString& messageUid : messageUids) {
+        qWarning() << "Message dropped before acknowledgement:" << messageUid;
+        emit messageStatusChanged(messageUid, MessageStatus::FAILED);
+    }
+}
+
 void MqttMessageHandler::handleMessage(const MessagePtr& message)
 {
     qDebug() << "Handling message:" << message->getUid() << "type:" << message->getTypeString();
-    emit messageReceived(message);
+    deliverMessage(message);
 }
 
 void MqttMessageHandler::handleTypingMessage(const MessagePtr& message)
 {
     QString threadUid = message->getThreadUid();
     QString userUid = message->getUserUid();
-    emit typingReceived(threadUid, userUid);
+
+    const QString extra = message->getExtra();
+    const bool typing = extraValue(extra, EXTRA_TYPING) != QLatin1String("false");
+
+    if (typing) {
+        emit typingReceived(threadUid, userUid);
+    }
+    m_typingEngine->remoteTyping(threadUid, userUid, typing);
 }
 
 void MqttMessageHandler::handleReceiptMessage(const MessagePtr& message)
 {
     QString threadUid = message->getThreadUid();
-    QString messageUid = message->getContentString();
+    QString messageUid = message->getContentText();
 
     if (message->getType() == MessageType::READ) {
         emit readReceiptReceived(threadUid, messageUid);
+
+        // 带水位的READ：该时间及之前的消息全部已读
+        const QString extra = message->getExtra();
+        const QStringView value = extraValue(extra, EXTRA_READ_UP_TO);
+        if (!value.isEmpty()) {
+            const QDateTime readUpTo = QDateTime::fromString(value, Qt::ISODateWithMs);
+            if (readUpTo.isValid()) {
+                {
+                    QMutexLocker locker(&m_mutex);
+                    QDateTime& current = m_peerReadWatermarks[threadUid];
+                    if (current.isValid() && readUpTo <= current) {
+                        return;
+                    }
+                    current = readUpTo;
+                }
+                emit readWatermarkReceived(threadUid, messageUid, readUpTo);
+            }
+        }
     } else if (message->getType() == MessageType::DELIVERED) {
         emit deliveredReceiptReceived(threadUid, messageUid);
     }
 }
 
-void MqttMessageHandler::handleNoticeMessage(const MessagePtr& message)
+QStringView MqttMessageHandler::extraValue(QStringView extra, QStringView key)
 {
-    QString threadUid = message->getThreadUid();
-    QString content = message->getContentString();
-    emit noticeReceived(threadUid, content);
+    qsizetype from = 0;
+    for (;;) {
+        const qsizetype start = extra.indexOf(key, from);
+        if (start < 0) {
+            return {};
+        }
+        from = start + key.size();
+
+        // 只接受带引号的完整键名，且后面紧跟冒号
+        qsizetype pos = from;
+        if (start == 0 || extra.at(start - 1) != u'"' || pos >= extra.size() || extra.at(pos) != u'"') {
+            continue;
+        }
+        ++pos;
+        while (pos < extra.size() && extra.at(pos).isSpace()) {
+            ++pos;
+        }
+        if (pos >= extra.size() || extra.at(pos) != u':') {
+            continue;
+        }
+        ++pos;
+        while (pos < extra.size() && extra.at(pos).isSpace()) {
+            ++pos;
+        }
+
+        // 字符串值去掉引号（水位是ISO时间，不含转义）；其他值截到下一个分隔符
+        if (pos < extra.size() && extra.at(pos) == u'"') {
+            const qsizetype end = extra.indexOf(u'"', pos + 1);
+            return end < 0 ? QStringView() : extra.sliced(pos + 1, end - pos - 1);
+        }
+        qsizetype end = pos;
+        while (end < extra.size() && extra.at(end) != u',' && extra.at(end) != u'}' && !extra.at(end).isSpace()) {
+            ++end;
+        }
+        return extra.sliced(pos, end - pos);
+    }
 }
 
-QString MqttMessageHandler::generateMessageUid()
+void MqttMessageHandler::handleNoticeMessage(const MessagePtr& message)
 {
-    return QUuid::createUuid().toString(QUuid::WithoutBraces);
+    QString threadUid = message->getThreadUid();
+    QString content = message->getContentText();
+    emit noticeReceived(threadUid, content);
 }
 
-void MqttMessageHandler::addToSentMessages(const QString& uid)
+void MqttMessageHandler::handleQueueMessage(const MessagePtr& message)
 {
-    QMutexLocker locker(&m_mutex);
-    // 限制集合大小，避免内存无限增长
-    if (m_sentReadUids.size() > 1000) {
-        m_sentReadUids.clear();
-    }
-    if (m_sentDeliveredUids.size() > 1000) {
-        m_sentDeliveredUids.clear();
-    }
-    m_sentReadUids.insert(uid);
-    m_sentDeliveredUids.insert(uid);
+    qDebug() << "Handling queue message:" << message->getUid();
+    emit queueMessageReceived(message);
 }
 
 } // namespace Bytedesk
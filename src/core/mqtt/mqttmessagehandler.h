@@ -3,15 +3,33 @@
 
 #include <QObject>
 #include <QHash>
+#include <QStringList>
 #include <QMutex>
+#include <QTimer>
+#include <QDateTime>
 #include "mqttclient.h"
+#include "mqtttopictrie.h"
+#include "mqttdedupcache.h"
+#include "mqtttypingengine.h"
+#include "mqttdecodepipeline.h"
+#include "core/protobuf/protobufwrapper.h"
 #include "models/message.h"
 #include "models/thread.h"
 #include "models/user.h"
 
 namespace Bytedesk {
 
+class MqttMessageBridge;
+
+// 出站消息的编码格式；入站消息总是自动识别
+enum class MqttWireFormat {
+    JSON = 0,
+    PROTOBUF = 1
+};
+
 // MQTT消息处理器 - 处理BYTDESK协议的消息
+// 必须与 MqttClient 位于同一线程（入站载荷为零拷贝视图，只能直连处理）；
+// 订阅和发送接口可在任意线程调用，会自动转发到处理器所在线程
 class MqttMessageHandler : public QObject
 {
     Q_OBJECT
@@ -23,58 +41,174 @@ public:
     // 初始化
     void init();
 
+    // 运行在网络线程时，通过桥接器把解码后的消息批量交给UI线程，
+    // 此时不再发出 messageReceived 信号；传入nullptr恢复直接发信号
+    void setMessageBridge(MqttMessageBridge* bridge);
+
+    // 出站编码格式（每个连接各自设置）；未编译Protobuf支持时回退为JSON
+    void setWireFormat(MqttWireFormat format);
+    MqttWireFormat getWireFormat() const { return m_wireFormat; }
+    // 入站解码统计，包含并行解码流水线各工作线程的解码器；线程安全
+    ProtobufDecodeStats getDecodeStats() const;
+
+    // 出站批量信封：需要服务端支持，默认关闭；入站信封总是自动识别
+    void setBatchEnvelopeEnabled(bool enabled) { m_batchEnvelopeEnabled = enabled; }
+    bool isBatchEnvelopeEnabled() const { return m_batchEnvelopeEnabled; }
+
+    // 去重缓存容量（入站消息、已发送的已读回执、已发送的送达回执各一个），修改后清空
+    void setDedupCapacity(int capacity);
+    MqttDedupStats getInboundDedupStats() const { return m_inboundDedup.getStats(); }
+    MqttDedupStats getReadReceiptDedupStats() const { return m_sentReadDedup.getStats(); }
+    MqttDedupStats getDeliveredReceiptDedupStats() const { return m_sentDeliveredDedup.getStats(); }
+    // 通过其他途径（如历史记录接口）已展示的消息，之后从MQTT重复收到时丢弃
+    void markMessageSeen(const QString& messageUid);
+
+    // 已读水位的合并窗口（毫秒）：窗口内同一会话的多次已读只发送最新的一条
+    void setReadWatermarkWindow(int milliseconds);
+    // 对方的已读水位：创建时间不晚于水位的消息都已读，O(1)判断，可在任意线程调用
+    QDateTime getPeerReadWatermark(const QString& threadUid) const;
+    bool isReadByPeer(const MessagePtr& message) const;
+
+    // 入站并行解码：0 为在当前线程同步解码（默认），小于0 使用CPU核心数；
+    // 同一会话的消息保持顺序，解码结果合并后通过 messagesReceived 批量交付
+    void setDecodeParallelism(int parallelism);
+    MqttDecodeStats getPipelineStats() const;
+
+    // 正在输入：出站发送间隔、停止输入多久后发送停止事件、入站状态的过期时间（毫秒）
+    void setTypingTimeouts(int sendInterval, int idleTimeout, int expiry);
+
     // 订阅主题
     void subscribeToThread(const QString& threadUid, const QString& topic);
     void unsubscribeFromThread(const QString& threadUid);
     void subscribeToQueue(const QString& agentUid);
     void unsubscribeFromQueue();
 
+    // 通配符订阅，例如 "org/agent/{agentUid}/#"：用少量过滤器覆盖大量会话主题，
+    // 已被覆盖的会话主题不再单独订阅，入站消息通过主题树分发
+    void subscribeToFilter(const QString& filter);
+    void unsubscribeFromFilter(const QString& filter);
+
+    // 根据 TOPIC_* 前缀判断主题类型
+    static MqttTopicKind topicKind(QStringView topic);
+
     // 发送消息
     void sendTextMessage(const ThreadPtr& thread, const QString& text, const UserPtr& user);
     void sendImageMessage(const ThreadPtr& thread, const QString& imageUrl, const UserPtr& user);
     void sendFileMessage(const ThreadPtr& thread, const QString& fileUrl,
                         const QString& fileName, qint64 fileSize, const UserPtr& user);
+    // 可在每次按键时调用，由输入状态引擎限流
     void sendTypingMessage(const ThreadPtr& thread, const UserPtr& user);
-    void sendReadReceipt(const ThreadPtr& thread, const QString& messageUid, const UserPtr& user);
+    // 已读回执按会话水位发送：读到 messageUid（创建时间 createdAt，缺省为当前时间）为止，
+    // 合并窗口结束后每个会话只发一条READ，并通过 readWatermarkFlushed 通知REST同步
+    void sendReadReceipt(const ThreadPtr& thread, const QString& messageUid, const UserPtr& user,
+                         const QDateTime& createdAt = QDateTime());
     void sendDeliveredReceipt(const ThreadPtr& thread, const QString& messageUid, const UserPtr& user);
 
-    // Protobuf序列化
+    // 批量发送：同一主题的消息合并为一个信封、一次QoS 1 PUBLISH，整批共用一个PUBACK；
+    // 未启用信封时逐条发送。本地回显通过 messagesReceived 一次交付
+    void sendMessages(const ThreadPtr& thread, const QList<MessagePtr>& messages);
+    // 向多个会话发送同一段文本（快捷回复），按主题分组
+    void sendTextMessages(const QList<ThreadPtr>& threads, const QString& text, const UserPtr& user);
+
+    // 序列化：按 getWireFormat() 编码；反序列化时根据载荷首字节区分JSON和Protobuf
     QByteArray serializeMessage(const Message& message);
     MessagePtr deserializeMessage(const QByteArray& data);
+    QByteArray serializeMessages(const QList<MessagePtr>& messages);
+    QList<MessagePtr> deserializeMessages(const QByteArray& data);
 
 signals:
     void messageReceived(const MessagePtr& message);
+    // 批量信封解包后的聊天消息，整批只发一次（使用桥接器时由桥接器交付）
+    void messagesReceived(const QList<MessagePtr>& messages);
+    // 发出的消息状态变化（SENDING -> SENT / FAILED）
+    // 按值传递：消息对象交付给UI之后，网络线程不再修改它
+    void messageStatusChanged(const QString& messageUid, MessageStatus status);
     void typingReceived(const QString& threadUid, const QString& userUid);
+    // 对方输入状态变化（开始 / 停止或过期）
+    void typingStateChanged(const QString& threadUid, const QString& userUid, bool typing);
     void readReceiptReceived(const QString& threadUid, const QString& messageUid);
+    // 本地已读水位已通过MQTT发出
+    void readWatermarkFlushed(const QString& threadUid, const QString& messageUid, const QDateTime& readUpTo);
+    // 收到对方的已读水位，readUpTo 及之前的消息都已读
+    void readWatermarkReceived(const QString& threadUid, const QString& messageUid, const QDateTime& readUpTo);
     void deliveredReceiptReceived(const QString& threadUid, const QString& messageUid);
     void noticeReceived(const QString& threadUid, const QString& content);
+    void queueMessageReceived(const MessagePtr& message);
 
 private slots:
     void onMqttMessageReceived(const QString& topic, const QByteArray& payload);
+    void onMqttReadBatchFinished();
     void onMqttConnected();
     void onMqttDisconnected();
     void onMqttError(const QString& error);
+    void onMqttPublishAcknowledged(quint16 packetId, qint64 latencyMs);
+    void onMqttPublishDropped(quint16 packetId);
+    void flushReadWatermarks();
+    void onPublishTyping(const ThreadPtr& thread, const UserPtr& user, bool typing);
+    void onPipelineDecoded(const QList<MqttDecodedPayload>& batch);
 
 private:
+    bool isOtherThread() const;
+    void deliverMessage(const MessagePtr& message);
+    void deliverMessages(const QList<MessagePtr>& messages);
+    void publishMessage(const ThreadPtr& thread, const MessagePtr& message);
+    void publishMessages(const QString& topic, const QList<MessagePtr>& messages);
+    // 按类型分发；chatMessages 不为空时普通聊天消息收集到其中，由调用方批量交付
+    void dispatchMessage(const MessagePtr& message, const MqttTopicRoute& route,
+                         QList<MessagePtr>* chatMessages = nullptr);
     void handleMessage(const MessagePtr& message);
     void handleTypingMessage(const MessagePtr& message);
     void handleReceiptMessage(const MessagePtr& message);
     void handleNoticeMessage(const MessagePtr& message);
-
-    QString generateMessageUid();
-    void addToSentMessages(const QString& uid);
+    void handleQueueMessage(const MessagePtr& message);
+
+    // 与格式相关的解码，无状态，可在解码线程池中调用
+    static QList<MessagePtr> decodePayload(const QByteArray& payload, ProtobufDecoder& decoder);
+    // 从 extra 的扁平JSON中按键取值（字符串去掉引号），只做线性扫描不解析JSON；找不到时返回空
+    static QStringView extraValue(QStringView extra, QStringView key);
+    static QList<MessagePtr> decodeMessages(const QByteArray& data, ProtobufDecoder& decoder);
+    static MessagePtr decodeMessage(const QByteArray& data, ProtobufDecoder& decoder);
+
+    // 待发送的本地已读水位
+    struct ReadWatermark {
+        ThreadPtr thread;
+        UserPtr user;
+        QString messageUid;
+        QDateTime readUpTo;
+    };
 
     MqttClient* m_mqttClient;
+    MqttMessageBridge* m_bridge;
+    MqttWireFormat m_wireFormat;
+    ProtobufDecoder m_protobufDecoder; // 同步路径的入站解码，每批 readyRead 回收一次Arena
+    ProtobufDecodeStats m_decodeStats;        // m_protobufDecoder 每批结束时的快照（受 m_mutex 保护）
+    ProtobufDecodeStats m_retiredDecodeStats; // 已替换的解码流水线的统计（受 m_mutex 保护）
+    bool m_batchEnvelopeEnabled;
     UserPtr m_currentUser;
 
     // 主题映射
     QHash<QString, QString> m_threadTopics; // threadUid -> topic
-    QHash<QString, QString> m_topicThreads; // topic -> threadUid
+    MqttTopicTrie m_topicRoutes;            // 主题/过滤器 -> 会话与处理方式
+    MqttTopicTrie m_wildcardFilters;        // 已订阅的通配符过滤器
+    QString m_queueTopic;
+
+    // 等待broker确认的消息：packetId -> messages（批量信封中的消息共用一个packetId）
+    QHash<quint16, QStringList> m_pendingAcks;    // packetId -> 等待确认的消息UID
+
+    // 去重：QoS 1 重发、历史与实时重叠的入站消息，以及重复发送的回执
+    MqttDedupCache m_inboundDedup;
+    MqttDedupCache m_sentReadDedup;
+    MqttDedupCache m_sentDeliveredDedup;
+    mutable QMutex m_mutex;
 
-    // 防止重复处理回执消息
-    QSet<QString> m_sentReadUids;
-    QSet<QString> m_sentDeliveredUids;
-    QMutex m_mutex;
+    // 已读水位：待合并发送的、已发送的（不回退）、对方的（受 m_mutex 保护）
+    QHash<QString, ReadWatermark> m_pendingReadWatermarks;
+    QHash<QString, QDateTime> m_sentReadWatermarks;
+    QHash<QString, QDateTime> m_peerReadWatermarks;
+    QTimer* m_readWatermarkTimer;
+
+    MqttTypingEngine* m_typingEngine;
+    MqttDecodePipeline* m_decodePipeline;
 
     // 消息类型常量
     static const QString MESSAGE_TYPE_TEXT;
@@ -96,6 +230,14 @@ private:
     static const QString TOPIC_ORG_GROUP_PREFIX;
     static const QString TOPIC_ORG_MEMBER_PREFIX;
     static const QString TOPIC_QUEUE_PREFIX;
+
+    // 单个信封最多携带的消息数，避免超出broker的报文大小限制
+    static constexpr int MAX_BATCH_MESSAGES = 100;
+
+    // READ消息 extra 中的水位字段
+    static const QString EXTRA_READ_UP_TO;
+    // TYPING消息 extra 中的输入状态字段，false 表示停止输入
+    static const QString EXTRA_TYPING;
 };
 
 } // namespace Bytedesk
@@ -0,0 +1,249 @@
+#include "mqttpacket.h"
+#include <QtGlobal>
+#include <cstring>
+
+namespace Bytedesk {
+
+qint64 MqttPacketReader::readFrom(QIODevice* device)
+{
+    const qint64 available = device->bytesAvailable();
+    if (available <= 0) {
+        return 0;
+    }
+
+    // 直接读入缓冲区尾部，避免 readAll() 产生的临时QByteArray
+    const qsizetype oldSize = m_buffer.size();
+    m_buffer.resize(oldSize + available);
+    const qint64 bytesRead = device->read(m_buffer.data() + oldSize, available);
+    m_buffer.resize(oldSize + qMax<qint64>(bytesRead, 0));
+    return bytesRead;
+}
+
+void MqttPacketReader::append(QByteArrayView data)
+{
+    m_buffer.append(data);
+}
+
+MqttPacketReader::Result MqttPacketReader::next(MqttPacket& packet)
+{
+    const qsizetype available = m_buffer.size() - m_offset;
+    if (available < 2) {
+        return Result::NEED_MORE;
+    }
+
+    const char* data = m_buffer.constData() + m_offset;
+
+    quint32 remainingLength = 0;
+    const int lengthBytes = decodeRemainingLength(data + 1, available - 1, remainingLength);
+    if (lengthBytes < 0) {
+        return Result::MALFORMED;
+    }
+    if (lengthBytes == 0) {
+        return Result::NEED_MORE;
+    }
+
+    const qsizetype headerSize = 1 + lengthBytes;
+    if (available < headerSize + static_cast<qsizetype>(remainingLength)) {
+        return Result::NEED_MORE; // 等待更多数据
+    }
+
+    packet.header = static_cast<quint8>(data[0]);
+    packet.body = QByteArrayView(data + headerSize, static_cast<qsizetype>(remainingLength));
+
+    m_offset += headerSize + remainingLength;
+    return Result::PACKET;
+}
+
+void MqttPacketReader::compact()
+{
+    if (m_offset == 0) {
+        return;
+    }
+
+    if (m_offset >= m_buffer.size()) {
+        // 全部消费完，保留已分配的容量
+        m_buffer.resize(0);
+    } else {
+        m_buffer.remove(0, m_offset);
+    }
+    m_offset = 0;
+}
+
+void MqttPacketReader::clear()
+{
+    m_buffer.resize(0);
+    m_offset = 0;
+}
+
+int MqttPacketReader::decodeRemainingLength(const char* data, qsizetype size, quint32& value)
+{
+    quint32 result = 0;
+    int shift = 0;
+
+    for (int i = 0; i < MqttProtocol::MAX_REMAINING_LENGTH_BYTES; ++i) {
+        if (i >= size) {
+            return 0; // 数据不足
+        }
+
+        const quint8 byte = static_cast<quint8>(data[i]);
+        result |= static_cast<quint32>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            value = result;
+            return i + 1;
+        }
+        shift += 7;
+    }
+
+    return -1; // 超过4字节
+}
+
+bool MqttPacketReader::parsePublish(const MqttPacket& packet, MqttPublishView& publish)
+{
+    const QByteArrayView body = packet.body;
+    if (body.size() < 2) {
+        return false;
+    }
+
+    const qsizetype topicLen = (static_cast<quint8>(body[0]) << 8) | static_cast<quint8>(body[1]);
+    qsizetype pos = 2 + topicLen;
+    if (pos > body.size()) {
+        return false;
+    }
+
+    publish.topic = body.sliced(2, topicLen);
+    publish.qos = (packet.flags() >> 1) & 0x03;
+    publish.retain = (packet.flags() & 0x01) != 0;
+    publish.dup = (packet.flags() & 0x08) != 0;
+    publish.packetId = 0;
+
+    if (publish.qos > 0) {
+        if (pos + 2 > body.size()) {
+            return false;
+        }
+        publish.packetId = static_cast<quint16>((static_cast<quint8>(body[pos]) << 8) |
+                                                static_cast<quint8>(body[pos + 1]));
+        pos += 2;
+    }
+
+    publish.payload = body.sliced(pos);
+    return true;
+}
+
+MqttPacketBuilder::MqttPacketBuilder(quint8 header, quint32 remainingLength)
+{
+    Q_ASSERT(remainingLength <= MqttProtocol::MAX_REMAINING_LENGTH);
+
+    const qsizetype totalSize = 1 + remainingLengthSize(remainingLength) + remainingLength;
+    m_data = QByteArray(totalSize, Qt::Uninitialized);
+    m_cursor = m_data.data();
+
+    writeByte(header);
+
+    // Remaining Length 变长编码
+    quint32 length = remainingLength;
+    do {
+        quint8 byte = length & 0x7F;
+        length >>= 7;
+        if (length > 0) {
+            byte |= 0x80;
+        }
+        writeByte(byte);
+    } while (length > 0);
+}
+
+void MqttPacketBuilder::writeByte(quint8 value)
+{
+    Q_ASSERT(m_cursor < m_data.constData() + m_data.size());
+    *m_cursor++ = static_cast<char>(value);
+}
+
+void MqttPacketBuilder::writeUint16(quint16 value)
+{
+    writeByte(static_cast<quint8>(value >> 8));
+    writeByte(static_cast<quint8>(value & 0xFF));
+}
+
+void MqttPacketBuilder::writeString(QStringView str)
+{
+    // 超长会被截断成错误的长度前缀，整个报文随之错位
+    const qsizetype size = utf8Size(str);
+    Q_ASSERT_X(size <= MqttProtocol::MAX_STRING_LENGTH, "MqttPacketBuilder::writeString",
+               "string exceeds 65535 bytes");
+    writeUint16(static_cast<quint16>(size));
+
+    // 直接编码到输出缓冲区，避免 toUtf8() 的临时分配
+    const qsizetype length = str.size();
+    for (qsizetype i = 0; i < length; ++i) {
+        char32_t ch = str[i].unicode();
+
+        if (QChar::isHighSurrogate(ch) && i + 1 < length && str[i + 1].isLowSurrogate()) {
+            ch = QChar::surrogateToUcs4(static_cast<char16_t>(ch), str[i + 1].unicode());
+            ++i;
+        } else if (QChar::isSurrogate(ch)) {
+            ch = QChar::ReplacementCharacter; // 孤立代理项
+        }
+
+        if (ch < 0x80) {
+            writeByte(static_cast<quint8>(ch));
+        } else if (ch < 0x800) {
+            writeByte(static_cast<quint8>(0xC0 | (ch >> 6)));
+            writeByte(static_cast<quint8>(0x80 | (ch & 0x3F)));
+        } else if (ch < 0x10000) {
+            writeByte(static_cast<quint8>(0xE0 | (ch >> 12)));
+            writeByte(static_cast<quint8>(0x80 | ((ch >> 6) & 0x3F)));
+            writeByte(static_cast<quint8>(0x80 | (ch & 0x3F)));
+        } else {
+            writeByte(static_cast<quint8>(0xF0 | (ch >> 18)));
+            writeByte(static_cast<quint8>(0x80 | ((ch >> 12) & 0x3F)));
+            writeByte(static_cast<quint8>(0x80 | ((ch >> 6) & 0x3F)));
+            writeByte(static_cast<quint8>(0x80 | (ch & 0x3F)));
+        }
+    }
+}
+
+void MqttPacketBuilder::writeBytes(QByteArrayView data)
+{
+    if (data.isEmpty()) {
+        return;
+    }
+    Q_ASSERT(m_cursor + data.size() <= m_data.constData() + m_data.size());
+    memcpy(m_cursor, data.data(), data.size());
+    m_cursor += data.size();
+}
+
+QByteArray MqttPacketBuilder::take()
+{
+    Q_ASSERT(m_cursor == m_data.constData() + m_data.size());
+    m_cursor = nullptr;
+    return std::move(m_data);
+}
+
+int MqttPacketBuilder::remainingLengthSize(quint32 remainingLength)
+{
+    if (remainingLength < 128) return 1;
+    if (remainingLength < 16384) return 2;
+    if (remainingLength < 2097152) return 3;
+    return 4;
+}
+
+qsizetype MqttPacketBuilder::utf8Size(QStringView str)
+{
+    qsizetype size = 0;
+    const qsizetype length = str.size();
+    for (qsizetype i = 0; i < length; ++i) {
+        const char16_t ch = str[i].unicode();
+        if (ch < 0x80) {
+            size += 1;
+        } else if (ch < 0x800) {
+            size += 2;
+        } else if (QChar::isHighSurrogate(ch) && i + 1 < length && str[i + 1].isLowSurrogate()) {
+            size += 4;
+            ++i;
+        } else {
+            size += 3; // BMP字符或被替换的孤立代理项
+        }
+    }
+    return size;
+}
+
+} // namespace Bytedesk
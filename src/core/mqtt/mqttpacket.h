@@ -0,0 +1,125 @@
+#ifndef MQTTPACKET_H
+#define MQTTPACKET_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QIODevice>
+#include <QStringView>
+
+namespace Bytedesk {
+
+// MQTT协议常量
+namespace MqttProtocol {
+    const quint8 CONNECT = 0x10;
+    const quint8 CONNACK = 0x20;
+    const quint8 PUBLISH = 0x30;
+    const quint8 PUBACK = 0x40;
+    const quint8 PUBREC = 0x50;
+    const quint8 PUBREL = 0x62;
+    const quint8 PUBCOMP = 0x70;
+    const quint8 SUBSCRIBE = 0x82;
+    const quint8 SUBACK = 0x90;
+    const quint8 UNSUBSCRIBE = 0xA2;
+    const quint8 UNSUBACK = 0xB0;
+    const quint8 PINGREQ = 0xC0;
+    const quint8 PINGRESP = 0xD0;
+    const quint8 DISCONNECT = 0xE0;
+
+    // Remaining Length 最多4字节，最大值 268,435,455
+    const int MAX_REMAINING_LENGTH_BYTES = 4;
+    const quint32 MAX_REMAINING_LENGTH = 268435455;
+
+    // UTF-8字符串字段的长度前缀为2字节，最长 65,535 字节
+    const qsizetype MAX_STRING_LENGTH = 65535;
+}
+
+// 解码后的MQTT报文
+// 注意：body 直接指向读取缓冲区（零拷贝），只在下一次 compact() 之前有效
+struct MqttPacket {
+    quint8 header = 0;      // 固定报头首字节（类型 + 标志位）
+    QByteArrayView body;    // 可变报头 + 载荷
+
+    quint8 type() const { return header & 0xF0; }
+    quint8 flags() const { return header & 0x0F; }
+};
+
+// PUBLISH报文的解析结果，同样是指向读取缓冲区的视图
+struct MqttPublishView {
+    QByteArrayView topic;
+    QByteArrayView payload;
+    quint16 packetId = 0;
+    quint8 qos = 0;
+    bool retain = false;
+    bool dup = false;
+};
+
+// 流式MQTT报文解码器
+// 维护一个可增长的读取缓冲区和读偏移量，逐个交出报文视图，
+// 每次 readyRead 结束时调用 compact() 统一回收已消费的数据
+class MqttPacketReader
+{
+public:
+    enum class Result {
+        PACKET,     // 解出一个完整报文
+        NEED_MORE,  // 数据不足，等待更多数据
+        MALFORMED   // 报文格式错误（Remaining Length 超过4字节）
+    };
+
+    // 从设备中读取所有可用数据，直接写入缓冲区尾部
+    qint64 readFrom(QIODevice* device);
+    void append(QByteArrayView data);
+
+    // 解析下一个报文
+    Result next(MqttPacket& packet);
+
+    // 丢弃已消费的数据（每批次调用一次）
+    void compact();
+    void clear();
+
+    qsizetype pendingBytes() const { return m_buffer.size() - m_offset; }
+
+    // 解码 Remaining Length
+    // 返回消耗的字节数；0 表示数据不足；-1 表示格式错误
+    static int decodeRemainingLength(const char* data, qsizetype size, quint32& value);
+
+    // 解析PUBLISH报文的可变报头
+    static bool parsePublish(const MqttPacket& packet, MqttPublishView& publish);
+
+private:
+    QByteArray m_buffer;
+    qsizetype m_offset = 0;
+};
+
+// 出站报文构建器
+// 先由调用方计算出精确的 Remaining Length，构造时一次性分配整帧内存，
+// 之后按顺序写入固定报头、变长长度、UTF-8字符串和载荷，不产生中间QByteArray
+class MqttPacketBuilder
+{
+public:
+    MqttPacketBuilder(quint8 header, quint32 remainingLength);
+
+    void writeByte(quint8 value);
+    void writeUint16(quint16 value);
+    void writeString(QStringView str);      // 2字节长度前缀 + UTF-8，调用方须先用 fitsString 检查
+    void writeBytes(QByteArrayView data);
+
+    // 取出构建好的完整报文
+    QByteArray take();
+
+    // Remaining Length 编码所需字节数（1~4）
+    static int remainingLengthSize(quint32 remainingLength);
+    // 字符串的UTF-8编码长度（不分配内存）
+    static qsizetype utf8Size(QStringView str);
+    // MQTT字符串字段长度：2字节长度前缀 + UTF-8
+    static qsizetype stringSize(QStringView str) { return 2 + utf8Size(str); }
+    // 字符串能否放进MQTT字符串字段（UTF-8不超过65535字节）
+    static bool fitsString(QStringView str) { return utf8Size(str) <= MqttProtocol::MAX_STRING_LENGTH; }
+
+private:
+    QByteArray m_data;
+    char* m_cursor;
+};
+
+} // namespace Bytedesk
+
+#endif // MQTTPACKET_H
@@ -0,0 +1,127 @@
+#include "mqttsessionstore.h"
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFile>
+#include <QDir>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QDebug>
+
+namespace Bytedesk {
+
+namespace {
+
+const quint32 SESSION_MAGIC = 0x42444D53; // "BDMS"
+const quint16 SESSION_VERSION = 1;
+
+} // namespace
+
+MqttSessionStore::MqttSessionStore(const QString& directory)
+    : m_directory(directory)
+{
+    if (m_directory.isEmpty()) {
+        m_directory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+                    + "/mqtt-sessions";
+    }
+}
+
+QString MqttSessionStore::filePath(const QString& clientId) const
+{
+    // 客户端ID包含 '/' 等字符，用哈希作为文件名
+    const QByteArray hash = QCryptographicHash::hash(clientId.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return m_directory + "/" + QString::fromLatin1(hash) + ".session";
+}
+
+bool MqttSessionStore::load(const QString& clientId, MqttSessionState& state) const
+{
+    QFile file(filePath(clientId));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    QString storedClientId;
+    in >> magic >> version >> storedClientId;
+    if (magic != SESSION_MAGIC || version != SESSION_VERSION || storedClientId != clientId) {
+        qWarning() << "MQTT session file ignored:" << file.fileName();
+        return false;
+    }
+
+    MqttSessionState loaded;
+    quint32 count = 0;
+
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString topic;
+        quint8 qos = 0;
+        in >> topic >> qos;
+        loaded.subscriptions.insert(topic, qos);
+    }
+
+    in >> loaded.pendingUnsubscribes;
+
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        MqttSessionState::OutboundMessage message;
+        in >> message.packetId >> message.qos >> message.packet
+           >> message.topic >> message.payload >> message.retain >> message.released;
+        loaded.outbound.append(message);
+    }
+
+    in >> loaded.incomingQos2Ids >> loaded.lastPacketId;
+
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "MQTT session file corrupted:" << file.fileName();
+        return false;
+    }
+
+    state = loaded;
+    return true;
+}
+
+bool MqttSessionStore::save(const QString& clientId, const MqttSessionState& state) const
+{
+    if (!QDir().mkpath(m_directory)) {
+        qWarning() << "MQTT session directory not writable:" << m_directory;
+        return false;
+    }
+
+    QSaveFile file(filePath(clientId));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "MQTT session save failed:" << file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+
+    out << SESSION_MAGIC << SESSION_VERSION << clientId;
+
+    out << static_cast<quint32>(state.subscriptions.size());
+    for (auto it = state.subscriptions.cbegin(); it != state.subscriptions.cend(); ++it) {
+        out << it.key() << it.value();
+    }
+
+    out << state.pendingUnsubscribes;
+
+    out << static_cast<quint32>(state.outbound.size());
+    for (const MqttSessionState::OutboundMessage& message : state.outbound) {
+        out << message.packetId << message.qos << message.packet
+            << message.topic << message.payload << message.retain << message.released;
+    }
+
+    out << state.incomingQos2Ids << state.lastPacketId;
+
+    return file.commit();
+}
+
+void MqttSessionStore::remove(const QString& clientId) const
+{
+    QFile::remove(filePath(clientId));
+}
+
+} // namespace Bytedesk
@@ -0,0 +1,58 @@
+#ifndef MQTTSESSIONSTORE_H
+#define MQTTSESSIONSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QByteArray>
+
+namespace Bytedesk {
+
+// 持久会话中需要跨进程保存的客户端状态
+struct MqttSessionState {
+    // 未确认的出站QoS>0报文
+    struct OutboundMessage {
+        quint16 packetId = 0;
+        quint8 qos = 0;
+        QByteArray packet;      // 已发送的完整PUBLISH帧；为空表示尚未发送（窗口已满排队）
+        QString topic;          // 仅排队中的报文使用
+        QByteArray payload;
+        bool retain = false;
+        bool released = false;  // QoS 2：已发送PUBREL
+    };
+
+    QHash<QString, quint8> subscriptions;   // broker已持有的订阅
+    QStringList pendingUnsubscribes;        // 本地已取消、尚未通知broker的订阅
+    QList<OutboundMessage> outbound;        // 按发送顺序排列
+    QList<quint16> incomingQos2Ids;         // 已回复PUBREC、等待PUBREL的入站报文
+    quint16 lastPacketId = 0;
+
+    bool isEmpty() const {
+        return subscriptions.isEmpty() && pendingUnsubscribes.isEmpty() &&
+               outbound.isEmpty() && incomingQos2Ids.isEmpty();
+    }
+};
+
+// MQTT会话本地存储
+// 每个客户端ID一个紧凑的二进制文件（QDataStream），通过QSaveFile原子替换，
+// 进程崩溃时不会留下写了一半的文件
+class MqttSessionStore
+{
+public:
+    // directory 为空时使用应用数据目录下的 mqtt-sessions
+    explicit MqttSessionStore(const QString& directory = QString());
+
+    bool load(const QString& clientId, MqttSessionState& state) const;
+    bool save(const QString& clientId, const MqttSessionState& state) const;
+    void remove(const QString& clientId) const;
+
+    QString filePath(const QString& clientId) const;
+
+private:
+    QString m_directory;
+};
+
+} // namespace Bytedesk
+
+#endif // MQTTSESSIONSTORE_H
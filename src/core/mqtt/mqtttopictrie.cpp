@@ -0,0 +1,205 @@
+#include "mqtttopictrie.h"
+#include <algorithm>
+
+namespace Bytedesk {
+
+struct MqttTopicTrie::Node {
+    QString level;
+    std::vector<std::unique_ptr<Node>> children; // 按level排序，二分查找
+    std::unique_ptr<Node> singleLevel;           // '+'
+    std::unique_ptr<Node> multiLevel;            // '#'
+    bool hasRoute = false;
+    MqttTopicRoute route;
+
+    bool isEmpty() const {
+        return !hasRoute && children.empty() && !singleLevel && !multiLevel;
+    }
+};
+
+namespace {
+
+// 返回 [start, end) 为当前层级，end 为下一个 '/' 的位置或字符串末尾
+qsizetype levelEnd(QStringView topic, qsizetype start)
+{
+    const qsizetype end = topic.indexOf(u'/', start);
+    return end < 0 ? topic.size() : end;
+}
+
+} // namespace
+
+MqttTopicTrie::MqttTopicTrie()
+    : m_root(std::make_unique<Node>())
+    , m_size(0)
+{
+}
+
+MqttTopicTrie::~MqttTopicTrie() = default;
+
+void MqttTopicTrie::insert(QStringView filter, const MqttTopicRoute& route)
+{
+    Node* node = m_root.get();
+    qsizetype start = 0;
+
+    while (start <= filter.size()) {
+        const qsizetype end = levelEnd(filter, start);
+        const QStringView level = filter.sliced(start, end - start);
+
+        if (level == u"+") {
+            if (!node->singleLevel) {
+                node->singleLevel = std::make_unique<Node>();
+                node->singleLevel->level = QStringLiteral("+");
+            }
+            node = node->singleLevel.get();
+        } else if (level == u"#") {
+            if (!node->multiLevel) {
+                node->multiLevel = std::make_unique<Node>();
+                node->multiLevel->level = QStringLiteral("#");
+            }
+            node = node->multiLevel.get();
+            break; // '#' 必须是最后一层
+        } else {
+            node = findOrCreateChild(node, level);
+        }
+
+        start = end + 1;
+    }
+
+    if (!node->hasRoute) {
+        ++m_size;
+    }
+    node->hasRoute = true;
+    node->route = route;
+}
+
+bool MqttTopicTrie::remove(QStringView filter)
+{
+    bool removed = false;
+    removeFrom(m_root.get(), filter, 0, removed);
+    if (removed) {
+        --m_size;
+    }
+    return removed;
+}
+
+void MqttTopicTrie::clear()
+{
+    m_root = std::make_unique<Node>();
+    m_size = 0;
+}
+
+const MqttTopicRoute* MqttTopicTrie::match(QStringView topic) const
+{
+    if (m_size == 0) {
+        return nullptr;
+    }
+    return matchFrom(m_root.get(), topic, 0, true);
+}
+
+const MqttTopicRoute* MqttTopicTrie::matchFrom(const Node* node, QStringView topic,
+                                               qsizetype start, bool atRoot)
+{
+    if (start > topic.size()) {
+        // 所有层级都已匹配
+        if (node->hasRoute) {
+            return &node->route;
+        }
+        // "a/#" 同样匹配 "a"
+        if (node->multiLevel && node->multiLevel->hasRoute) {
+            return &node->multiLevel->route;
+        }
+        return nullptr;
+    }
+
+    const qsizetype end = levelEnd(topic, start);
+    const QStringView level = topic.sliced(start, end - start);
+
+    // 精确层级优先
+    if (const Node* child = findChild(node, level)) {
+        if (const MqttTopicRoute* route = matchFrom(child, topic, end + 1, false)) {
+            return route;
+        }
+    }
+
+    // 以 '$' 开头的主题不参与首层通配符匹配
+    if (atRoot && level.startsWith(u'$')) {
+        return nullptr;
+    }
+
+    if (node->singleLevel) {
+        if (const MqttTopicRoute* route = matchFrom(node->singleLevel.get(), topic, end + 1, false)) {
+            return route;
+        }
+    }
+
+    if (node->multiLevel && node->multiLevel->hasRoute) {
+        return &node->multiLevel->route;
+    }
+
+    return nullptr;
+}
+
+bool MqttTopicTrie::removeFrom(Node* node, QStringView filter, qsizetype start, bool& removed)
+{
+    if (start > filter.size()) {
+        if (node->hasRoute) {
+            node->hasRoute = false;
+            node->route = MqttTopicRoute();
+            removed = true;
+        }
+        return node->isEmpty();
+    }
+
+    const qsizetype end = levelEnd(filter, start);
+    const QStringView level = filter.sliced(start, end - start);
+
+    if (level == u"+") {
+        if (node->singleLevel && removeFrom(node->singleLevel.get(), filter, end + 1, removed)) {
+            node->singleLevel.reset();
+        }
+    } else if (level == u"#") {
+        // '#' 为最后一层，直接在该节点上删除
+        if (node->multiLevel && removeFrom(node->multiLevel.get(), filter, filter.size() + 1, removed)) {
+            node->multiLevel.reset();
+        }
+    } else {
+        auto it = std::lower_bound(node->children.begin(), node->children.end(), level,
+                                   [](const std::unique_ptr<Node>& child, QStringView value) {
+                                       return QStringView(child->level).compare(value) < 0;
+                                   });
+        if (it != node->children.end() && QStringView((*it)->level) == level &&
+            removeFrom(it->get(), filter, end + 1, removed)) {
+            node->children.erase(it);
+        }
+    }
+
+    return node->isEmpty();
+}
+
+const MqttTopicTrie::Node* MqttTopicTrie::findChild(const Node* node, QStringView level)
+{
+    auto it = std::lower_bound(node->children.cbegin(), node->children.cend(), level,
+                               [](const std::unique_ptr<Node>& child, QStringView value) {
+                                   return QStringView(child->level).compare(value) < 0;
+                               });
+    if (it != node->children.cend() && QStringView((*it)->level) == level) {
+        return it->get();
+    }
+    return nullptr;
+}
+
+MqttTopicTrie::Node* MqttTopicTrie::findOrCreateChild(Node* node, QStringView level)
+{
+    auto it = std::lower_bound(node->children.begin(), node->children.end(), level,
+                               [](const std::unique_ptr<Node>& child, QStringView value) {
+                                   return QStringView(child->level).compare(value) < 0;
+                               });
+    if (it != node->children.end() && QStringView((*it)->level) == level) {
+        return it->get();
+    }
+
+    auto child = std::make_unique<Node>();
+    child->level = level.toString();
+    return node->children.insert(it, std::move(child))->get();
+}
+
+} // namespace Bytedesk
@@ -0,0 +1,68 @@
+#ifndef MQTTTOPICTRIE_H
+#define MQTTTOPICTRIE_H
+
+#include <QString>
+#include <QStringView>
+#include <memory>
+#include <vector>
+
+namespace Bytedesk {
+
+// 主题类型，对应 MqttMessageHandler 中的 TOPIC_* 前缀
+enum class MqttTopicKind {
+    UNKNOWN = 0,
+    AGENT = 1,
+    WORKGROUP = 2,
+    ROBOT = 3,
+    GROUP = 4,
+    MEMBER = 5,
+    QUEUE = 6
+};
+
+// 主题路由信息
+struct MqttTopicRoute {
+    MqttTopicKind kind = MqttTopicKind::UNKNOWN;
+    QString threadUid; // 精确主题对应的会话，通配符过滤器为空
+};
+
+// MQTT主题过滤器前缀树
+// 支持 '+'（单层）和 '#'（多层）通配符；匹配时按层级逐级查找，
+// 精确层级优先于 '+'，'+' 优先于 '#'，整个过程不分配内存
+class MqttTopicTrie
+{
+public:
+    MqttTopicTrie();
+    ~MqttTopicTrie();
+
+    MqttTopicTrie(const MqttTopicTrie&) = delete;
+    MqttTopicTrie& operator=(const MqttTopicTrie&) = delete;
+
+    // 插入或覆盖过滤器对应的路由
+    void insert(QStringView filter, const MqttTopicRoute& route);
+    // 删除过滤器，返回是否存在
+    bool remove(QStringView filter);
+    void clear();
+
+    // 查找与主题匹配的路由，未匹配时返回nullptr
+    const MqttTopicRoute* match(QStringView topic) const;
+    bool contains(QStringView topic) const { return match(topic) != nullptr; }
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+private:
+    struct Node;
+
+    static const MqttTopicRoute* matchFrom(const Node* node, QStringView topic,
+                                           qsizetype start, bool atRoot);
+    static bool removeFrom(Node* node, QStringView filter, qsizetype start, bool& removed);
+    static const Node* findChild(const Node* node, QStringView level);
+    static Node* findOrCreateChild(Node* node, QStringView level);
+
+    std::unique_ptr<Node> m_root;
+    int m_size;
+};
+
+} // namespace Bytedesk
+
+#endif // MQTTTOPICTRIE_H
@@ -0,0 +1,154 @@
+#include "mqtttypingengine.h"
+#include <utility>
+
+namespace Bytedesk {
+
+MqttTypingEngine::MqttTypingEngine(QObject* parent)
+    : QObject(parent)
+    , m_tickTimer(new QTimer(this))
+    , m_sendInterval(3000)
+    , m_idleTimeout(5000)
+    , m_expiry(6000)
+    , m_wheel(WHEEL_SLOTS)
+    , m_tick(0)
+{
+    m_tickTimer->setInterval(TICK_MS);
+    connect(m_tickTimer, &QTimer::timeout, this, &MqttTypingEngine::onTick);
+    m_clock.start();
+}
+
+MqttTypingEngine::~MqttTypingEngine()
+{
+}
+
+void MqttTypingEngine::setSendInterval(int milliseconds)
+{
+    m_sendInterval = qMax(0, milliseconds);
+}
+
+void MqttTypingEngine::setIdleTimeout(int milliseconds)
+{
+    m_idleTimeout = qMax(TICK_MS, milliseconds);
+}
+
+void MqttTypingEngine::setExpiry(int milliseconds)
+{
+    m_expiry = qMax(TICK_MS, milliseconds);
+}
+
+void MqttTypingEngine::localTyping(const ThreadPtr& thread, const UserPtr& user)
+{
+    if (!thread || !user) {
+        return;
+    }
+
+    const qint64 now = m_clock.elapsed();
+
+    auto it = m_local.find(thread->getUid());
+    if (it == m_local.end()) {
+        it = m_local.insert(thread->getUid(), LocalTyping());
+    } else if (now - it->lastSentAt < m_sendInterval) {
+        // 间隔内只记录输入时间，不重复发送
+        it->lastInputAt = now;
+        return;
+    }
+
+    it->thread = thread;
+    it->user = user;
+    it->lastSentAt = now;
+    it->lastInputAt = now;
+
+    emit publishTyping(thread, user, true);
+    ensureTicking();
+}
+
+void MqttTypingEngine::localStopped(const QString& threadUid)
+{
+    m_local.remove(threadUid);
+}
+
+void MqttTypingEngine::remoteTyping(const QString& threadUid, const QString& userUid, bool typing)
+{
+    const QString key = remoteKey(threadUid, userUid);
+
+    if (!typing) {
+        if (m_remote.remove(key)) {
+            emit typingStateChanged(threadUid, userUid, false);
+        }
+        return;
+    }
+
+    const qint64 expireTick = m_tick + (m_expiry + TICK_MS - 1) / TICK_MS;
+
+    auto it = m_remote.find(key);
+    const bool started = (it == m_remote.end());
+    if (started) {
+        it = m_remote.insert(key, {threadUid, userUid, expireTick});
+    } else {
+        it->expireTick = expireTick;
+    }
+    m_wheel[static_cast<size_t>(expireTick % WHEEL_SLOTS)].append(key);
+
+    if (started) {
+        emit typingStateChanged(threadUid, userUid, true);
+    }
+    ensureTicking();
+}
+
+void MqttTypingEngine::onTick()
+{
+    ++m_tick;
+
+    // 入站：只处理当前格子
+    QStringList& slot = m_wheel[static_cast<size_t>(m_tick % WHEEL_SLOTS)];
+    const QStringList keys = std::exchange(slot, QStringList());
+    for (const QString& key : keys) {
+        auto it = m_remote.find(key);
+        if (it == m_remote.end()) {
+            continue;
+        }
+        if (it->expireTick > m_tick) {
+            // 超过一圈的条目留在本格等下一圈；已刷新到其他格子的引用直接丢弃
+            if (it->expireTick % WHEEL_SLOTS == m_tick % WHEEL_SLOTS) {
+                slot.append(key);
+            }
+            continue;
+        }
+        const RemoteTyping expired = *it;
+        m_remote.erase(it);
+        emit typingStateChanged(expired.threadUid, expired.userUid, false);
+    }
+
+    // 出站：正在输入的会话很少，直接遍历；先摘除再发信号，避免槽函数修改 m_local
+    const qint64 now = m_clock.elapsed();
+    QList<LocalTyping> idle;
+    for (auto it = m_local.begin(); it != m_local.end();) {
+        if (now - it->lastInputAt >= m_idleTimeout) {
+            idle.append(*it);
+            it = m_local.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (const LocalTyping& local : idle) {
+        emit publishTyping(local.thread, local.user, false);
+    }
+
+    if (m_local.isEmpty() && m_remote.isEmpty()) {
+        m_tickTimer->stop();
+    }
+}
+
+QString MqttTypingEngine::remoteKey(const QString& threadUid, const QString& userUid)
+{
+    return threadUid + QLatin1Char('/') + userUid;
+}
+
+void MqttTypingEngine::ensureTicking()
+{
+    if (!m_tickTimer->isActive()) {
+        m_tickTimer->start();
+    }
+}
+
+} // namespace Bytedesk
@@ -0,0 +1,93 @@
+#ifndef MQTTTYPINGENGINE_H
+#define MQTTTYPINGENGINE_H
+
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <vector>
+#include "models/thread.h"
+#include "models/user.h"
+
+namespace Bytedesk {
+
+// 正在输入状态引擎
+// 出站：每个会话在发送间隔内最多发一次TYPING，停止输入超过空闲时间后发一次停止事件；
+// 入站：“某用户在某会话输入中”的条目放在时间轮中，到期自动清除，
+// 对外只发出状态变化（开始/结束），不转发原始事件。
+// 非线程安全，与 MqttMessageHandler 位于同一线程
+class MqttTypingEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MqttTypingEngine(QObject* parent = nullptr);
+    ~MqttTypingEngine();
+
+    // 同一会话两次TYPING之间的最小间隔
+    void setSendInterval(int milliseconds);
+    // 最后一次输入后多久发送停止事件
+    void setIdleTimeout(int milliseconds);
+    // 收到TYPING后多久没有刷新即视为停止
+    void setExpiry(int milliseconds);
+
+    // 本地输入（每次按键调用即可）
+    void localTyping(const ThreadPtr& thread, const UserPtr& user);
+    // 本地已发送消息：对方收到消息会自行清除输入状态，这里只清本地状态，不再发停止事件
+    void localStopped(const QString& threadUid);
+
+    // 收到对方的TYPING（typing=false 为停止事件）
+    void remoteTyping(const QString& threadUid, const QString& userUid, bool typing);
+
+    // 当前处于输入状态的对方用户数
+    int remoteCount() const { return static_cast<int>(m_remote.size()); }
+
+signals:
+    // 需要发布TYPING（typing=false 为停止事件）
+    void publishTyping(const ThreadPtr& thread, const UserPtr& user, bool typing);
+    // 对方输入状态变化
+    void typingStateChanged(const QString& threadUid, const QString& userUid, bool typing);
+
+private slots:
+    void onTick();
+
+private:
+    struct LocalTyping {
+        ThreadPtr thread;
+        UserPtr user;
+        qint64 lastSentAt = 0;
+        qint64 lastInputAt = 0;
+    };
+
+    struct RemoteTyping {
+        QString threadUid;
+        QString userUid;
+        qint64 expireTick = 0;
+    };
+
+    static QString remoteKey(const QString& threadUid, const QString& userUid);
+    void ensureTicking();
+
+    QTimer* m_tickTimer;
+    QElapsedTimer m_clock;
+
+    int m_sendInterval;
+    int m_idleTimeout;
+    int m_expiry;
+
+    QHash<QString, LocalTyping> m_local;    // threadUid -> 本地输入状态
+
+    // 时间轮：每格 TICK_MS，条目按到期刻度放入对应格子；
+    // 刷新时只追加到新格子，旧格子中的过期引用在轮到时惰性丢弃
+    std::vector<QStringList> m_wheel;
+    QHash<QString, RemoteTyping> m_remote;  // threadUid/userUid -> 对方输入状态
+    qint64 m_tick;
+
+    static constexpr int TICK_MS = 250;
+    static constexpr int WHEEL_SLOTS = 64;
+};
+
+} // namespace Bytedesk
+
+#endif // MQTTTYPINGENGINE_H
@@ -0,0 +1,100 @@
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace Bytedesk {
+
+// 单生产者/单消费者无锁环形缓冲区
+// 只允许一个线程调用 tryPush、另一个线程调用 tryPop；
+// 容量向上取整为2的幂，读写索引单调递增，通过掩码定位槽位
+template <typename T>
+class SpscRingBuffer
+{
+public:
+    explicit SpscRingBuffer(std::size_t capacity)
+        : m_slots(roundUpPowerOfTwo(capacity))
+        , m_mask(m_slots.size() - 1)
+    {
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    // 生产者线程调用，缓冲区已满时返回false
+    bool tryPush(T&& value)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_cachedTail == m_slots.size()) {
+            // 缓存的读索引可能已过期，重新读取一次
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cachedTail == m_slots.size()) {
+                return false;
+            }
+        }
+
+        m_slots[head & m_mask] = std::move(value);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPush(const T& value)
+    {
+        T copy(value);
+        return tryPush(std::move(copy));
+    }
+
+    // 消费者线程调用，缓冲区为空时返回false
+    bool tryPop(T& value)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_cachedHead) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail == m_cachedHead) {
+                return false;
+            }
+        }
+
+        // 移出元素，槽位中不再持有引用
+        value = std::move(m_slots[tail & m_mask]);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 当前元素个数（任意线程调用，结果为近似值）
+    std::size_t size() const
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_acquire);
+        const std::size_t head = m_head.load(std::memory_order_acquire);
+        return head - tail;
+    }
+
+    bool isEmpty() const { return size() == 0; }
+    std::size_t capacity() const { return m_slots.size(); }
+
+private:
+    static std::size_t roundUpPowerOfTwo(std::size_t value)
+    {
+        std::size_t result = 2;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    std::vector<T> m_slots;
+    const std::size_t m_mask;
+
+    // 读写索引分别放在独立的缓存行，避免伪共享
+    alignas(64) std::atomic<std::size_t> m_head{0}; // 生产者写
+    std::size_t m_cachedTail = 0;                   // 仅生产者访问
+    alignas(64) std::atomic<std::size_t> m_tail{0}; // 消费者写
+    std::size_t m_cachedHead = 0;                   // 仅消费者访问
+};
+
+} // namespace Bytedesk
+
+#endif // SPSCRINGBUFFER_H
@@ -5,6 +5,11 @@ namespace Bytedesk {
 AuthApi::AuthApi(HttpClient* httpClient, QObject* parent)
     : ApiBase(httpClient, parent)
 {
+    // 当前用户资料很少变化，5分钟内直接使用缓存；本地修改资料后失效
+    httpClient->cache()->setPolicy(m_userPath + "/current", 5 * 60 * 1000);
+
+    // 登录在用户的等待路径上，不能沿用30秒的默认期限
+    httpClient->setEndpointTimeout(m_authPath, 15000);
 }
 
 AuthApi::~AuthApi()
@@ -216,6 +221,7 @@ void AuthApi::updateProfile(const QString& nickname, const QString& avatar,
 
             if (success) {
                 qDebug() << "Profile updated successfully";
+                httpClient()->invalidateCache(m_userPath + "/current");
             } else {
                 QString message = getResponseMessage(response);
                 qWarning() << "Failed to update profile:" << message;
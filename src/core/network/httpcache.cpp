@@ -0,0 +1,236 @@
+#include "httpcache.h"
+#include <QNetworkDiskCache>
+#include <QNetworkCacheMetaData>
+#include <QNetworkReply>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+
+namespace Bytedesk {
+
+HttpCache::HttpCache(QObject* parent)
+    : QObject(parent)
+    , m_diskCache(nullptr)
+    , m_maximumSize(DEFAULT_MAXIMUM_SIZE)
+{
+}
+
+HttpCache::~HttpCache()
+{
+}
+
+void HttpCache::setDirectory(const QString& directory)
+{
+    delete m_diskCache;
+    m_diskCache = nullptr;
+
+    if (directory.isEmpty()) {
+        qDebug() << "HTTP cache disabled";
+        return;
+    }
+
+    m_diskCache = new QNetworkDiskCache(this);
+    m_diskCache->setCacheDirectory(directory);
+    m_diskCache->setMaximumCacheSize(m_maximumSize);
+    qDebug() << "HTTP cache directory:" << directory << "max size:" << m_maximumSize;
+}
+
+void HttpCache::setMaximumSize(qint64 bytes)
+{
+    m_maximumSize = bytes > 0 ? bytes : DEFAULT_MAXIMUM_SIZE;
+    if (m_diskCache) {
+        m_diskCache->setMaximumCacheSize(m_maximumSize);
+    }
+}
+
+void HttpCache::setPolicy(const QString& endpoint, int ttlMs)
+{
+    m_policies[endpoint] = qMax(0, ttlMs);
+}
+
+void HttpCache::removePolicy(const QString& endpoint)
+{
+    m_policies.remove(endpoint);
+}
+
+bool HttpCache::isCacheable(const QNetworkRequest& request) const
+{
+    return m_diskCache && policyFor(request.url()) >= 0;
+}
+
+bool HttpCache::lookup(const QNetworkRequest& request, Entry* entry)
+{
+    if (!isCacheable(request)) {
+        return false;
+    }
+
+    QNetworkCacheMetaData metaData;
+    if (!readEntry(cacheKey(request), entry, &metaData)) {
+        return false;
+    }
+
+    if (entry->fresh) {
+        m_stats.hits++;
+        m_stats.bytesSaved += static_cast<quint64>(entry->body.size());
+    }
+    return true;
+}
+
+void HttpCache::prepareRevalidation(QNetworkRequest& request, const Entry& entry) const
+{
+    if (!entry.etag.isEmpty()) {
+        request.setRawHeader("If-None-Match", entry.etag);
+    }
+    if (!entry.lastModified.isEmpty()) {
+        request.setRawHeader("If-Modified-Since", entry.lastModified);
+    }
+}
+
+void HttpCache::store(const QNetworkRequest& request, QNetworkReply* reply, const QByteArray& body)
+{
+    if (!isCacheable(request)) {
+        return;
+    }
+    m_stats.misses++;
+
+    const int ttl = policyFor(request.url());
+    const QByteArray etag = reply->rawHeader("ETag");
+    const QByteArray lastModified = reply->rawHeader("Last-Modified");
+    const QByteArray cacheControl = reply->rawHeader("Cache-Control");
+
+    // 服务端禁止保存，或者既无验证器又不允许TTL内复用，都没有缓存的意义
+    if (cacheControl.contains("no-store") || (ttl == 0 && etag.isEmpty() && lastModified.isEmpty())) {
+        return;
+    }
+
+    QNetworkCacheMetaData::RawHeaderList headers;
+    if (!etag.isEmpty()) {
+        headers.append({"ETag", etag});
+    }
+    if (!lastModified.isEmpty()) {
+        headers.append({"Last-Modified", lastModified});
+    }
+
+    QNetworkCacheMetaData metaData;
+    metaData.setUrl(cacheKey(request));
+    metaData.setRawHeaders(headers);
+    metaData.setLastModified(QDateTime::currentDateTimeUtc());
+    metaData.setExpirationDate(QDateTime::currentDateTimeUtc().addMSecs(ttl));
+    metaData.setSaveToDisk(true);
+
+    QIODevice* device = m_diskCache->prepare(metaData);
+    if (!device) {
+        return;
+    }
+    device->write(body);
+    m_diskCache->insert(device);
+    m_stats.stores++;
+}
+
+void HttpCache::refresh(const QNetworkRequest& request, QNetworkReply* reply, const Entry& entry)
+{
+    m_stats.revalidated++;
+    m_stats.bytesSaved += static_cast<quint64>(entry.body.size());
+
+    if (!isCacheable(request)) {
+        return;
+    }
+
+    QNetworkCacheMetaData metaData = m_diskCache->metaData(cacheKey(request));
+    if (!metaData.isValid()) {
+        return;
+    }
+
+    metaData.setExpirationDate(QDateTime::currentDateTimeUtc().addMSecs(policyFor(request.url())));
+
+    // 304可能带回新的验证器
+    const QByteArray etag = reply->rawHeader("ETag");
+    if (!etag.isEmpty() && etag != entry.etag) {
+        QNetworkCacheMetaData::RawHeaderList headers;
+        headers.append({"ETag", etag});
+        if (!entry.lastModified.isEmpty()) {
+            headers.append({"Last-Modified", entry.lastModified});
+        }
+        metaData.setRawHeaders(headers);
+    }
+    m_diskCache->updateMetaData(metaData);
+}
+
+void HttpCache::remove(const QNetworkRequest& request)
+{
+    if (m_diskCache) {
+        m_diskCache->remove(cacheKey(request));
+    }
+}
+
+void HttpCache::clear()
+{
+    if (m_diskCache) {
+        m_diskCache->clear();
+    }
+}
+
+HttpCacheStats HttpCache::getStats() const
+{
+    HttpCacheStats stats = m_stats;
+    stats.diskSize = m_diskCache ? m_diskCache->cacheSize() : 0;
+    return stats;
+}
+
+bool HttpCache::readEntry(const QUrl& key, Entry* entry, QNetworkCacheMetaData* metaData) const
+{
+    *metaData = m_diskCache->metaData(key);
+    if (!metaData->isValid()) {
+        return false;
+    }
+
+    QIODevice* device = m_diskCache->data(key);
+    if (!device) {
+        return false;
+    }
+    entry->body = device->readAll();
+    delete device;
+
+    entry->etag.clear();
+    entry->lastModified.clear();
+    for (const QNetworkCacheMetaData::RawHeader& header : metaData->rawHeaders()) {
+        if (header.first.compare("ETag", Qt::CaseInsensitive) == 0) {
+            entry->etag = header.second;
+        } else if (header.first.compare("Last-Modified", Qt::CaseInsensitive) == 0) {
+            entry->lastModified = header.second;
+        }
+    }
+    entry->fresh = metaData->expirationDate() > QDateTime::currentDateTimeUtc();
+    return true;
+}
+
+QUrl HttpCache::cacheKey(const QNetworkRequest& request) const
+{
+    // 键只用于本地缓存，不会发送到服务端。认证头摘要放在路径前缀里区分不同身份：
+    // QNetworkDiskCache 计算文件名时会去掉片段，放在片段里所有身份会共用一个条目
+    QUrl key = request.url();
+    const QByteArray auth = request.rawHeader("Authorization");
+    if (!auth.isEmpty()) {
+        const QString digest = QString::fromLatin1(QCryptographicHash::hash(auth, QCryptographicHash::Sha1).toHex());
+        key.setPath(QStringLiteral("/_auth/") + digest + key.path());
+    }
+    return key;
+}
+
+int HttpCache::policyFor(const QUrl& url) const
+{
+    // 基础URL以/结尾、接口路径以/开头，拼接后会出现 //
+    QString path = url.path();
+    while (path.contains(QLatin1String("//"))) {
+        path.replace(QLatin1String("//"), QLatin1String("/"));
+    }
+
+    for (auto it = m_policies.constBegin(); it != m_policies.constEnd(); ++it) {
+        if (path.endsWith(it.key())) {
+            return it.value();
+        }
+    }
+    return -1;
+}
+
+} // namespace Bytedesk
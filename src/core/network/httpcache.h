@@ -0,0 +1,93 @@
+#ifndef HTTPCACHE_H
+#define HTTPCACHE_H
+
+#include <QObject>
+#include <QNetworkRequest>
+#include <QByteArray>
+#include <QHash>
+#include <QUrl>
+
+class QNetworkDiskCache;
+class QNetworkCacheMetaData;
+class QNetworkReply;
+
+namespace Bytedesk {
+
+// HTTP缓存统计
+struct HttpCacheStats {
+    quint64 hits = 0;           // TTL内直接命中，未访问网络
+    quint64 revalidated = 0;    // 条件请求返回304，复用缓存内容
+    quint64 misses = 0;         // 可缓存的GET从网络取回完整响应
+    quint64 stores = 0;         // 写入缓存的响应数
+    quint64 bytesSaved = 0;     // 命中和304节省的响应体字节数
+    qint64 diskSize = 0;        // 磁盘缓存当前大小
+
+    double hitRate() const {
+        const quint64 total = hits + revalidated + misses;
+        return total > 0 ? static_cast<double>(hits + revalidated) / static_cast<double>(total) : 0.0;
+    }
+};
+
+// REST响应缓存
+// 只缓存登记了策略的GET接口。TTL内直接返回缓存；过期后带 If-None-Match / If-Modified-Since
+// 重新验证，304时复用缓存内容并续期。缓存键的路径带认证头摘要，不同用户的响应分开存放、互不可见。
+// 内容保存在大小受限的 QNetworkDiskCache 中，未设置目录时缓存关闭
+class HttpCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Entry {
+        QByteArray body;
+        QByteArray etag;
+        QByteArray lastModified;
+        bool fresh = false;
+    };
+
+    explicit HttpCache(QObject* parent = nullptr);
+    ~HttpCache();
+
+    // 磁盘目录与容量；目录为空时关闭缓存
+    void setDirectory(const QString& directory);
+    void setMaximumSize(qint64 bytes);
+    bool isEnabled() const { return m_diskCache != nullptr; }
+
+    // 接口缓存策略：endpoint 为接口路径（如 /api/v1/thread/list），ttlMs 为0时每次都重新验证
+    void setPolicy(const QString& endpoint, int ttlMs);
+    void removePolicy(const QString& endpoint);
+    bool isCacheable(const QNetworkRequest& request) const;
+
+    // 查找缓存；找到时填充 entry 并返回true
+    bool lookup(const QNetworkRequest& request, Entry* entry);
+
+    // 为过期条目添加条件请求头
+    void prepareRevalidation(QNetworkRequest& request, const Entry& entry) const;
+
+    // 保存200响应
+    void store(const QNetworkRequest& request, QNetworkReply* reply, const QByteArray& body);
+
+    // 304后为条目续期，entry 为发出条件请求时查到的缓存
+    void refresh(const QNetworkRequest& request, QNetworkReply* reply, const Entry& entry);
+
+    // 删除某个请求的缓存（资源被修改后调用）
+    void remove(const QNetworkRequest& request);
+    void clear();
+
+    HttpCacheStats getStats() const;
+
+private:
+    bool readEntry(const QUrl& key, Entry* entry, QNetworkCacheMetaData* metaData) const;
+    QUrl cacheKey(const QNetworkRequest& request) const;
+    int policyFor(const QUrl& url) const;
+
+    QNetworkDiskCache* m_diskCache;
+    qint64 m_maximumSize;
+    QHash<QString, int> m_policies;   // 接口路径 -> TTL（毫秒）
+    HttpCacheStats m_stats;
+
+    static const qint64 DEFAULT_MAXIMUM_SIZE = 50 * 1024 * 1024;
+};
+
+} // namespace Bytedesk
+
+#endif // HTTPCACHE_H
@@ -4,14 +4,34 @@
 #include <QSslConfiguration>
 #include <QFileInfo>
 #include <QJsonArray>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QRandomGenerator>
+#include <QDateTime>
+#include <algorithm>
+#include <memory>
 
 namespace Bytedesk {
 
 HttpClient::HttpClient(QObject* parent)
     : QObject(parent)
     , m_networkManager(new QNetworkAccessManager(this))
+    , m_cache(new HttpCache(this))
     , m_timeout(30000) // 默认30秒超时
+    , m_hedgingEnabled(true)
+    , m_maxRetries(3)
+    , m_retryBaseDelay(500)
+    , m_retryMaxDelay(10000)
+    , m_circuitFailureThreshold(5)
+    , m_circuitCooldown(30000)
 {
+    // 生产环境应该验证证书
+    m_sslConfiguration = QSslConfiguration::defaultConfiguration();
+    m_sslConfiguration.setPeerVerifyMode(QSslSocket::VerifyNone);
+    // ALPN优先协商HTTP/2，预连接和请求使用同一配置，连接才能被复用
+    m_sslConfiguration.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2,
+                                                QSslConfiguration::NextProtocolHttp1_1});
 }
 
 HttpClient::~HttpClient()
@@ -25,6 +45,26 @@ void HttpClient::setBaseUrl(const QString& baseUrl)
         m_baseUrl += '/';
     }
     qDebug() << "HTTP base URL set to:" << m_baseUrl;
+
+    preconnect();
+}
+
+void HttpClient::preconnect()
+{
+    const QUrl url(m_baseUrl);
+    if (url.host().isEmpty()) {
+        return;
+    }
+
+    // 提前完成DNS、TCP和TLS握手，登录请求不再承担建连耗时
+    if (url.scheme() == "https") {
+        m_networkManager->connectToHostEncrypted(url.host(), static_cast<quint16>(url.port(443)),
+                                                 m_sslConfiguration);
+    } else {
+        m_networkManager->connectToHost(url.host(), static_cast<quint16>(url.port(80)));
+    }
+    m_stats.preconnects++;
+    qDebug() << "HTTP preconnect:" << url.host();
 }
 
 void HttpClient::setAccessToken(const QString& token)
@@ -42,16 +82,193 @@ void HttpClient::get(const QString& path, const QUrlQuery& params,
                     HttpCallback onSuccess, HttpErrorCallback onError)
 {
     QNetworkRequest request = createRequest(path, params);
-    QNetworkReply* reply = m_networkManager->get(request);
+    const QByteArray key = requestKey("GET", request);
+
+    m_stats.getRequests++;
+
+    // 相同的GET正在进行中，挂到它上面等待结果
+    auto pending = m_pendingGets.find(key);
+    if (pending != m_pendingGets.end()) {
+        pending->onSuccess.append(onSuccess);
+        pending->onError.append(onError);
+        m_stats.coalescedGets++;
+        qDebug() << "HTTP GET coalesced:" << request.url().toString()
+                 << "waiters:" << pending->onSuccess.size();
+        return;
+    }
 
-    connect(reply, &QNetworkReply::finished, this, [this, reply, onSuccess, onError]() {
-        handleResponse(reply, onSuccess, onError);
-        reply->deleteLater();
-    });
+    // TTL内的缓存直接返回（仍然异步回调）；过期的缓存改为条件请求
+    HttpCache::Entry cached;
+    const bool hasCached = m_cache->lookup(request, &cached);
+    if (hasCached && cached.fresh) {
+        const QString url = request.url().toString();
+        QMetaObject::invokeMethod(this, [this, url, cached, onSuccess, onError]() {
+            qDebug() << "HTTP cache hit:" << url;
+            handleSuccess(url, 200, cached.body, onSuccess, onError);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    // 熔断期间快速失败；有过期缓存时先用缓存顶上
+    if (!acquireCircuit(request.url().host())) {
+        if (hasCached) {
+            const QString url = request.url().toString();
+            QMetaObject::invokeMethod(this, [this, url, cached, onSuccess, onError]() {
+                qDebug() << "HTTP circuit open, serving stale cache:" << url;
+                handleSuccess(url, 200, cached.body, onSuccess, onError);
+            }, Qt::QueuedConnection);
+        } else {
+            rejectRequest(request.url(), onError);
+        }
+        return;
+    }
+
+    if (hasCached) {
+        m_cache->prepareRevalidation(request, cached);
+    }
+
+    PendingGet& entry = m_pendingGets[key];
+    entry.onSuccess.append(onSuccess);
+    entry.onError.append(onError);
+    entry.endpoint = path;
+    entry.request = request;
+    entry.hasCached = hasCached;
+    entry.cached = cached;
+    entry.deadline = QDeadlineTimer(timeoutFor(path));
+    m_stats.inFlightGets = m_pendingGets.size();
+
+    startGetAttempt(key);
+
+    // 对冲：超过该接口的P95延迟仍未返回，再发一个相同的请求；期限内来不及时不对冲
+    const qint64 hedgeDelay = hedgeDelayFor(path);
+    if (hedgeDelay > 0 && hedgeDelay < entry.deadline.remainingTime()) {
+        entry.hedgeTimer = new QTimer(this);
+        entry.hedgeTimer->setSingleShot(true);
+        connect(entry.hedgeTimer, &QTimer::timeout, this, [this, key]() {
+            auto it = m_pendingGets.find(key);
+            if (it == m_pendingGets.end() || it->replies.size() != 1 || it->deadline.hasExpired()) {
+                return;
+            }
+            if (!acquireCircuit(it->request.url().host())) {
+                return;
+            }
+            qDebug() << "HTTP GET hedged:" << it->request.url().toString();
+            m_stats.hedgedRequests++;
+            startGetAttempt(key);
+        });
+        entry.hedgeTimer->start(static_cast<int>(hedgeDelay));
+    }
 
     emit requestStarted(request.url().toString());
 }
 
+void HttpClient::startGetAttempt(const QByteArray& key)
+{
+    PendingGet& entry = m_pendingGets[key];
+
+    QNetworkReply* reply = m_networkManager->get(entry.request);
+    trackRequest(reply, "GET");
+    enforceDeadline(reply, entry.deadline);
+    entry.replies.append(reply);
+    entry.attemptTimers[reply].start();
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply, key]() {
+        onGetFinished(key, reply);
+    });
+}
+
+void HttpClient::onGetFinished(const QByteArray& key, QNetworkReply* reply)
+{
+    auto it = m_pendingGets.find(key);
+    if (it == m_pendingGets.end()) {
+        reply->deleteLater();
+        return;
+    }
+
+    // 对冲中的另一个请求还在进行，失败的这个不作数
+    if (reply->error() != QNetworkReply::NoError && it->replies.size() > 1) {
+        it->replies.removeOne(reply);
+        it->attemptTimers.remove(reply);
+        reply->deleteLater();
+        return;
+    }
+
+    // 可重试的失败：等待者继续挂着，退避后重新请求；退避结束时已超过期限则不再重试
+    const qint64 delay = retryDelay("GET", reply, it->attempts);
+    if (delay >= 0 && delay < it->deadline.remainingTime()) {
+        it->replies.removeOne(reply);
+        it->attemptTimers.remove(reply);
+        it->attempts++;
+        reply->deleteLater();
+        m_stats.retries++;
+        qDebug() << "HTTP retry GET" << it->request.url().toString()
+                 << "attempt:" << it->attempts << "in" << delay << "ms";
+
+        QTimer::singleShot(static_cast<int>(delay), this, [this, key]() {
+            auto pending = m_pendingGets.find(key);
+            if (pending == m_pendingGets.end()) {
+                return;
+            }
+            const QUrl url = pending->request.url();
+            if (!acquireCircuit(url.host())) {
+                failPendingGet(key, circuitOpenError(url));
+                return;
+            }
+            startGetAttempt(key);
+        });
+        return;
+    }
+
+    // 先摘下等待者，回调中再发起的相同GET会重新请求
+    const PendingGet waiters = m_pendingGets.take(key);
+    m_stats.inFlightGets = m_pendingGets.size();
+
+    if (waiters.hedgeTimer) {
+        waiters.hedgeTimer->stop();
+        waiters.hedgeTimer->deleteLater();
+    }
+    for (QNetworkReply* other : waiters.replies) {
+        if (other != reply) {
+            disconnect(other, nullptr, this, nullptr);
+            other->abort();
+            other->deleteLater();
+        }
+    }
+    if (waiters.replies.size() > 1 && waiters.replies.constFirst() != reply) {
+        m_stats.hedgeWins++;
+    }
+
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    QByteArray data = reply->readAll();
+    if (reply->error() == QNetworkReply::NoError) {
+        // 只计成功的这一次请求本身的耗时，不含之前失败的尝试和退避等待
+        recordLatency(waiters.endpoint, waiters.attemptTimers.value(reply).elapsed());
+    }
+    if (statusCode == 304 && waiters.hasCached) {
+        m_cache->refresh(waiters.request, reply, waiters.cached);
+        data = waiters.cached.body;
+    } else if (reply->error() == QNetworkReply::NoError && statusCode == 200) {
+        m_cache->store(waiters.request, reply, data);
+    }
+
+    handleResponse(reply, data,
+        [waiters](const QJsonObject& response) {
+            for (const HttpCallback& callback : waiters.onSuccess) {
+                if (callback) {
+                    callback(response);
+                }
+            }
+        },
+        [waiters](const QString& error) {
+            for (const HttpErrorCallback& callback : waiters.onError) {
+                if (callback) {
+                    callback(error);
+                }
+            }
+        });
+    reply->deleteLater();
+}
+
 void HttpClient::post(const QString& path, const QJsonObject& data,
                      HttpCallback onSuccess, HttpErrorCallback onError)
 {
@@ -61,12 +278,14 @@ void HttpClient::post(const QString& path, const QJsonObject& data,
     QJsonDocument doc(data);
     QByteArray jsonData = doc.toJson(QJsonDocument::Compact);
 
-    QNetworkReply* reply = m_networkManager->post(request, jsonData);
+    if (!acquireCircuit(request.url().host())) {
+        rejectRequest(request.url(), onError);
+        return;
+    }
 
-    connect(reply, &QNetworkReply::finished, this, [this, reply, onSuccess, onError]() {
-        handleResponse(reply, onSuccess, onError);
-        reply->deleteLater();
-    });
+    sendRequest("POST", [this, request, jsonData]() {
+        return m_networkManager->post(request, jsonData);
+    }, onSuccess, onError, QDeadlineTimer(timeoutFor(path)));
 
     emit requestStarted(request.url().toString());
 }
@@ -80,12 +299,14 @@ void HttpClient::put(const QString& path, const QJsonObject& data,
     QJsonDocument doc(data);
     QByteArray jsonData = doc.toJson(QJsonDocument::Compact);
 
-    QNetworkReply* reply = m_networkManager->put(request, jsonData);
+    if (!acquireCircuit(request.url().host())) {
+        rejectRequest(request.url(), onError);
+        return;
+    }
 
-    connect(reply, &QNetworkReply::finished, this, [this, reply, onSuccess, onError]() {
-        handleResponse(reply, onSuccess, onError);
-        reply->deleteLater();
-    });
+    sendRequest("PUT", [this, request, jsonData]() {
+        return m_networkManager->put(request, jsonData);
+    }, onSuccess, onError, QDeadlineTimer(timeoutFor(path)));
 
     emit requestStarted(request.url().toString());
 }
@@ -94,14 +315,60 @@ void HttpClient::deleteResource(const QString& path,
                                HttpCallback onSuccess, HttpErrorCallback onError)
 {
     QNetworkRequest request = createRequest(path);
-    QNetworkReply* reply = m_networkManager->deleteResource(request);
 
-    connect(reply, &QNetworkReply::finished, this, [this, reply, onSuccess, onError]() {
-        handleResponse(reply, onSuccess, onError);
+    if (!acquireCircuit(request.url().host())) {
+        rejectRequest(request.url(), onError);
+        return;
+    }
+
+    sendRequest("DELETE", [this, request]() {
+        return m_networkManager->deleteResource(request);
+    }, onSuccess, onError, QDeadlineTimer(timeoutFor(path)));
+
+    emit requestStarted(request.url().toString());
+}
+
+void HttpClient::sendRequest(const QByteArray& method, std::function<QNetworkReply*()> send,
+                             HttpCallback onSuccess, HttpErrorCallback onError,
+                             const QDeadlineTimer& deadline, int attempt)
+{
+    QNetworkReply* reply = send();
+    trackRequest(reply, method);
+    enforceDeadline(reply, deadline);
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply, method, send, onSuccess, onError, deadline, attempt]() {
+        // 退避结束时已超过期限则不再重试
+        const qint64 delay = retryDelay(method, reply, attempt);
+        if (delay < 0 || delay >= deadline.remainingTime()) {
+            handleResponse(reply, onSuccess, onError);
+            reply->deleteLater();
+            return;
+        }
+
+        const QUrl url = reply->request().url();
         reply->deleteLater();
+        m_stats.retries++;
+        qDebug() << "HTTP retry" << method << url.toString() << "attempt:" << attempt + 1 << "in" << delay << "ms";
+
+        QTimer::singleShot(static_cast<int>(delay), this, [this, url, method, send, onSuccess, onError, deadline, attempt]() {
+            if (!acquireCircuit(url.host())) {
+                rejectRequest(url, onError);
+                return;
+            }
+            sendRequest(method, send, onSuccess, onError, deadline, attempt + 1);
+        });
     });
+}
 
-    emit requestStarted(request.url().toString());
+void HttpClient::enforceDeadline(QNetworkReply* reply, const QDeadlineTimer& deadline)
+{
+    // transferTimeout 只管连续无数据的时长，总时长由调用期限兜底；定时器随reply一起销毁
+    QTimer::singleShot(static_cast<int>(qMax<qint64>(0, deadline.remainingTime())), reply, [reply]() {
+        if (reply->isRunning()) {
+            qWarning() << "HTTP request deadline exceeded:" << reply->request().url().toString();
+            reply->abort();
+        }
+    });
 }
 
 void HttpClient::upload(const QString& path, const QString& fieldName,
@@ -110,6 +377,7 @@ void HttpClient::upload(const QString& path, const QString& fieldName,
 {
     QNetworkRequest request = createRequest(path);
 
+    // 与 download 相同，先准备好请求体再占用熔断器，避免本地失败占住半开状态的探测名额
     QHttpMultiPart* multiPart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
 
     // 添加文件
@@ -146,7 +414,14 @@ void HttpClient::upload(const QString& path, const QString& fieldName,
         multiPart->append(metaPart);
     }
 
+    if (!acquireCircuit(request.url().host())) {
+        delete multiPart;
+        rejectRequest(request.url(), onError);
+        return;
+    }
+
     QNetworkReply* reply = m_networkManager->post(request, multiPart);
+    trackRequest(reply, "POST");
 
     connect(reply, &QNetworkReply::uploadProgress, this, &HttpClient::onUploadProgress);
     connect(reply, &QNetworkReply::finished, this, [this, reply, multiPart, onSuccess, onError]() {
@@ -164,7 +439,6 @@ void HttpClient::download(const QString& path, const QString& savePath,
                          std::function<void(qint64, qint64)> onProgress)
 {
     QNetworkRequest request = createRequest(path);
-    QNetworkReply* reply = m_networkManager->get(request);
 
     DownloadInfo info;
     info.savePath = savePath;
@@ -173,6 +447,7 @@ void HttpClient::download(const QString& path, const QString& savePath,
     info.onError = onError;
     info.onProgress = onProgress;
 
+    // 先打开文件再占用熔断器：半开状态下 acquireCircuit 会占用唯一的探测名额，之后失败返回就无法归还
     if (!info.file->open(QIODevice::WriteOnly)) {
         QString error = QString("Failed to create file: %1").arg(savePath);
         qWarning() << error;
@@ -180,10 +455,19 @@ void HttpClient::download(const QString& path, const QString& savePath,
             onError(error);
         }
         delete info.file;
-        reply->deleteLater();
         return;
     }
 
+    if (!acquireCircuit(request.url().host())) {
+        info.file->remove();
+        delete info.file;
+        rejectRequest(request.url(), onError);
+        return;
+    }
+
+    QNetworkReply* reply = m_networkManager->get(request);
+    trackRequest(reply, "GET");
+
     m_downloads[reply] = info;
 
     connect(reply, &QNetworkReply::downloadProgress, this, &HttpClient::onDownloadProgress);
@@ -235,56 +519,31 @@ QNetworkRequest HttpClient::createRequest(const QString& path, const QUrlQuery&
         request.setRawHeader("Authorization", QString("Bearer %1").arg(m_accessToken).toUtf8());
     }
 
-    // SSL配置
-    QSslConfiguration sslConfig = request.sslConfiguration();
-    sslConfig.setPeerVerifyMode(QSslSocket::VerifyNone); // 生产环境应该验证证书
-    request.setSslConfiguration(sslConfig);
+    // SSL配置，允许HTTP/2：并发请求在同一连接上多路复用
+    request.setSslConfiguration(m_sslConfiguration);
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+
+    // 请求期限：超过该时间没有数据传输即中止
+    request.setTransferTimeout(timeoutFor(path));
 
     return request;
 }
 
 void HttpClient::handleResponse(QNetworkReply* reply, HttpCallback onSuccess, HttpErrorCallback onError)
+{
+    handleResponse(reply, reply->readAll(), onSuccess, onError);
+}
+
+void HttpClient::handleResponse(QNetworkReply* reply, const QByteArray& data,
+                                HttpCallback onSuccess, HttpErrorCallback onError)
 {
     int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-    QByteArray data = reply->readAll();
 
     QString url = reply->request().url().toString();
 
     if (reply->error() == QNetworkReply::NoError) {
         qDebug() << "HTTP success:" << statusCode << url;
-
-        QJsonParseError parseError;
-        QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
-
-        if (parseError.error == QJsonParseError::NoError) {
-            if (doc.isObject()) {
-                QJsonObject response = doc.object();
-                if (onSuccess) {
-                    onSuccess(response);
-                }
-            } else if (doc.isArray()) {
-                QJsonObject response;
-                response["data"] = doc.array();
-                if (onSuccess) {
-                    onSuccess(response);
-                }
-            } else {
-                // 空响应或非JSON响应
-                QJsonObject response;
-                response["statusCode"] = statusCode;
-                if (onSuccess) {
-                    onSuccess(response);
-                }
-            }
-        } else {
-            QString error = QString("Failed to parse response: %1").arg(parseError.errorString());
-            qWarning() << error;
-            if (onError) {
-                onError(error);
-            }
-        }
-
-        emit requestFinished(url, true);
+        handleSuccess(url, statusCode, data, onSuccess, onError);
     } else {
         QString error;
         QJsonParseError parseError;
@@ -303,6 +562,13 @@ void HttpClient::handleResponse(QNetworkReply* reply, HttpCallback onSuccess, Ht
             error = reply->errorString();
         }
 
+        // 本类只会因超时中止请求（对冲中落败的请求不会走到这里）
+        if (reply->error() == QNetworkReply::OperationCanceledError
+            || reply->error() == QNetworkReply::TimeoutError) {
+            error = QString("Request timed out after %1 ms").arg(reply->request().transferTimeout());
+            m_stats.timeouts++;
+        }
+
         qWarning() << "HTTP error:" << statusCode << error << url;
         if (onError) {
             onError(error);
@@ -313,6 +579,43 @@ void HttpClient::handleResponse(QNetworkReply* reply, HttpCallback onSuccess, Ht
     }
 }
 
+void HttpClient::handleSuccess(const QString& url, int statusCode, const QByteArray& data,
+                               HttpCallback onSuccess, HttpErrorCallback onError)
+{
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+
+    if (parseError.error == QJsonParseError::NoError) {
+        if (doc.isObject()) {
+            QJsonObject response = doc.object();
+            if (onSuccess) {
+                onSuccess(response);
+            }
+        } else if (doc.isArray()) {
+            QJsonObject response;
+            response["data"] = doc.array();
+            if (onSuccess) {
+                onSuccess(response);
+            }
+        } else {
+            // 空响应或非JSON响应
+            QJsonObject response;
+            response["statusCode"] = statusCode;
+            if (onSuccess) {
+                onSuccess(response);
+            }
+        }
+    } else {
+        QString error = QString("Failed to parse response: %1").arg(parseError.errorString());
+        qWarning() << error;
+        if (onError) {
+            onError(error);
+        }
+    }
+
+    emit requestFinished(url, true);
+}
+
 QString HttpClient::getFullUrl(const QString& path, const QUrlQuery& params)
 {
     QString url = m_baseUrl + path;
@@ -324,6 +627,358 @@ QString HttpClient::getFullUrl(const QString& path, const QUrlQuery& params)
     return url;
 }
 
+void HttpClient::trackRequest(QNetworkReply* reply, const QByteArray& method)
+{
+    m_stats.requests++;
+
+    // 各阶段的时间点，相对于请求发起（毫秒），-1 表示未发生
+    struct Timeline {
+        QElapsedTimer timer;
+        qint64 connecting = -1;
+        qint64 encrypted = -1;
+        qint64 sent = -1;
+        qint64 firstByte = -1;
+    };
+    auto timeline = std::make_shared<Timeline>();
+    timeline->timer.start();
+
+    connect(reply, &QNetworkReply::socketStartedConnecting, this, [timeline]() {
+        timeline->connecting = timeline->timer.elapsed();
+    });
+    connect(reply, &QNetworkReply::encrypted, this, [timeline]() {
+        timeline->encrypted = timeline->timer.elapsed();
+    });
+    connect(reply, &QNetworkReply::requestSent, this, [timeline]() {
+        timeline->sent = timeline->timer.elapsed();
+    });
+    connect(reply, &QNetworkReply::metaDataChanged, this, [timeline]() {
+        if (timeline->firstByte < 0) {
+            timeline->firstByte = timeline->timer.elapsed();
+        }
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, reply, method, timeline]() {
+        const qint64 total = timeline->timer.elapsed();
+        const qint64 sent = timeline->sent >= 0 ? timeline->sent : 0;
+        const qint64 firstByte = timeline->firstByte >= 0 ? timeline->firstByte : total;
+
+        HttpRequestTiming timing;
+        timing.method = method;
+        timing.url = reply->request().url().toString();
+        timing.statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        timing.success = reply->error() == QNetworkReply::NoError;
+        timing.http2 = reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool();
+        timing.reusedConnection = timeline->connecting < 0;
+        if (timeline->connecting >= 0) {
+            // 建连结束以TLS完成为准；明文连接没有 encrypted，以请求发出为准
+            const qint64 connected = timeline->encrypted >= 0 ? timeline->encrypted : sent;
+            timing.queueMs = timeline->connecting;
+            timing.connectMs = qMax<qint64>(0, connected - timeline->connecting);
+        } else {
+            timing.queueMs = sent;
+        }
+        timing.ttfbMs = qMax<qint64>(0, firstByte - sent);
+        timing.downloadMs = qMax<qint64>(0, total - firstByte);
+        timing.totalMs = total;
+
+        recordOutcome(reply);
+
+        if (timing.http2) {
+            m_stats.http2Responses++;
+        }
+        if (timing.reusedConnection) {
+            m_stats.reusedConnections++;
+        }
+
+        emit requestTimed(timing);
+    });
+}
+
+void HttpClient::failPendingGet(const QByteArray& key, const QString& error)
+{
+    const PendingGet waiters = m_pendingGets.take(key);
+    m_stats.inFlightGets = m_pendingGets.size();
+
+    if (waiters.hedgeTimer) {
+        waiters.hedgeTimer->stop();
+        waiters.hedgeTimer->deleteLater();
+    }
+
+    const QString url = waiters.request.url().toString();
+    qWarning() << "HTTP error:" << error << url;
+    for (const HttpErrorCallback& callback : waiters.onError) {
+        if (callback) {
+            callback(error);
+        }
+    }
+
+    emit requestFinished(url, false);
+    emit networkErrorOccurred(error);
+}
+
+void HttpClient::setRetryPolicy(int maxRetries, int baseDelay, int maxDelay)
+{
+    m_maxRetries = qMax(0, maxRetries);
+    m_retryBaseDelay = qMax(1, baseDelay);
+    m_retryMaxDelay = qMax(m_retryBaseDelay, maxDelay);
+}
+
+void HttpClient::setCircuitBreaker(int failureThreshold, int cooldown)
+{
+    m_circuitFailureThreshold = qMax(1, failureThreshold);
+    m_circuitCooldown = qMax(0, cooldown);
+}
+
+HttpCircuitState HttpClient::getCircuitState(const QString& host) const
+{
+    auto it = m_circuits.constFind(host);
+    return it != m_circuits.constEnd() ? it->state : HttpCircuitState::CLOSED;
+}
+
+qint64 HttpClient::retryDelay(const QByteArray& method, QNetworkReply* reply, int attempt) const
+{
+    // POST不是幂等的，重发可能造成重复提交
+    if (attempt >= m_maxRetries || method == "POST") {
+        return -1;
+    }
+
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const bool throttled = statusCode == 429 || statusCode == 503;
+    if (!throttled && !isRetryableError(reply)) {
+        return -1;
+    }
+
+    // 服务端已不可用，不再堆积请求
+    if (getCircuitState(reply->request().url().host()) == HttpCircuitState::OPEN) {
+        return -1;
+    }
+
+    // 服务端给出的等待时间优先；超过上限时放弃重试
+    if (throttled && reply->hasRawHeader("Retry-After")) {
+        const qint64 retryAfter = parseRetryAfter(reply->rawHeader("Retry-After"));
+        if (retryAfter >= 0) {
+            return retryAfter <= MAX_RETRY_AFTER ? retryAfter : -1;
+        }
+    }
+
+    // 指数退避加抖动：在 [上限/2, 上限] 之间随机，避免大量客户端同时重试
+    const qint64 ceiling = qMin<qint64>(m_retryMaxDelay, qint64(m_retryBaseDelay) << qMin(attempt, 16));
+    return ceiling / 2 + QRandomGenerator::global()->bounded(ceiling / 2 + 1);
+}
+
+bool HttpClient::isRetryableError(QNetworkReply* reply)
+{
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (statusCode == 408 || statusCode == 502 || statusCode == 504) {
+        return true;
+    }
+
+    switch (reply->error()) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::OperationCanceledError:   // 超过请求期限
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::UnknownNetworkError:
+    case QNetworkReply::ProxyConnectionRefusedError:
+    case QNetworkReply::ProxyConnectionClosedError:
+    case QNetworkReply::ProxyTimeoutError:
+        return true;
+    default:
+        return false;
+    }
+}
+
+qint64 HttpClient::parseRetryAfter(const QByteArray& value)
+{
+    // 秒数，或HTTP日期
+    bool ok = false;
+    const qint64 seconds = value.trimmed().toLongLong(&ok);
+    if (ok) {
+        return qMax<qint64>(0, seconds) * 1000;
+    }
+
+    const QDateTime date = QDateTime::fromString(QString::fromLatin1(value.trimmed()), Qt::RFC2822Date);
+    if (date.isValid()) {
+        return qMax<qint64>(0, QDateTime::currentDateTimeUtc().msecsTo(date));
+    }
+    return -1;
+}
+
+bool HttpClient::acquireCircuit(const QString& host)
+{
+    auto it = m_circuits.find(host);
+    if (it == m_circuits.end()) {
+        return true;
+    }
+
+    CircuitBreaker& circuit = it.value();
+    if (circuit.state == HttpCircuitState::OPEN) {
+        if (circuit.openTimer.elapsed() < m_circuitCooldown) {
+            return false;
+        }
+        // 冷却结束，放一个探测请求过去
+        setCircuitState(host, circuit, HttpCircuitState::HALF_OPEN);
+    }
+
+    if (circuit.state == HttpCircuitState::HALF_OPEN) {
+        if (circuit.probeInFlight) {
+            return false;
+        }
+        circuit.probeInFlight = true;
+    }
+    return true;
+}
+
+void HttpClient::recordOutcome(QNetworkReply* reply)
+{
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    // 4xx说明服务端正常工作，只有网络层失败和5xx计为故障
+    const bool failed = statusCode >= 500 || (statusCode == 0 && isRetryableError(reply));
+
+    const QString host = reply->request().url().host();
+    auto it = m_circuits.find(host);
+    if (it == m_circuits.end()) {
+        if (!failed) {
+            return;
+        }
+        it = m_circuits.insert(host, CircuitBreaker());
+    }
+
+    CircuitBreaker& circuit = it.value();
+    circuit.probeInFlight = false;
+
+    if (!failed) {
+        circuit.failures = 0;
+        if (circuit.state != HttpCircuitState::CLOSED) {
+            setCircuitState(host, circuit, HttpCircuitState::CLOSED);
+        }
+        return;
+    }
+
+    circuit.failures++;
+    if (circuit.state == HttpCircuitState::HALF_OPEN
+        || (circuit.state == HttpCircuitState::CLOSED && circuit.failures >= m_circuitFailureThreshold)) {
+        circuit.openTimer.start();
+        m_stats.circuitOpened++;
+        setCircuitState(host, circuit, HttpCircuitState::OPEN);
+    }
+}
+
+void HttpClient::setCircuitState(const QString& host, CircuitBreaker& circuit, HttpCircuitState state)
+{
+    circuit.state = state;
+    qDebug() << "HTTP circuit" << host << "state:" << static_cast<int>(state);
+    emit circuitStateChanged(host, state);
+}
+
+QString HttpClient::circuitOpenError(const QUrl& url) const
+{
+    return QString("Service unavailable, requests to %1 are paused").arg(url.host());
+}
+
+void HttpClient::rejectRequest(const QUrl& url, HttpErrorCallback onError)
+{
+    m_stats.circuitRejected++;
+
+    // 保持异步回调，与正常请求一致
+    const QString error = circuitOpenError(url);
+    const QString urlString = url.toString();
+    QMetaObject::invokeMethod(this, [this, error, urlString, onError]() {
+        qWarning() << "HTTP error:" << error << urlString;
+        if (onError) {
+            onError(error);
+        }
+        emit requestFinished(urlString, false);
+    }, Qt::QueuedConnection);
+}
+
+void HttpClient::setEndpointTimeout(const QString& endpoint, int milliseconds)
+{
+    if (milliseconds > 0) {
+        m_endpointTimeouts[endpoint] = milliseconds;
+    } else {
+        m_endpointTimeouts.remove(endpoint);
+    }
+}
+
+void HttpClient::setHedgedEndpoint(const QString& endpoint, bool hedged)
+{
+    if (hedged) {
+        m_latencies[endpoint];
+    } else {
+        m_latencies.remove(endpoint);
+    }
+}
+
+qint64 HttpClient::getLatencyP95(const QString& endpoint) const
+{
+    auto it = m_latencies.constFind(endpoint);
+    if (it == m_latencies.constEnd() || it->samples.size() < MIN_LATENCY_SAMPLES) {
+        return -1;
+    }
+
+    QList<qint64> sorted = it->samples;
+    const qsizetype index = (sorted.size() * 95 + 99) / 100 - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted.at(index);
+}
+
+int HttpClient::timeoutFor(const QString& path) const
+{
+    // 最长前缀匹配
+    int timeout = m_timeout;
+    qsizetype matched = -1;
+    for (auto it = m_endpointTimeouts.constBegin(); it != m_endpointTimeouts.constEnd(); ++it) {
+        if (path.startsWith(it.key()) && it.key().size() > matched) {
+            matched = it.key().size();
+            timeout = it.value();
+        }
+    }
+    return timeout;
+}
+
+qint64 HttpClient::hedgeDelayFor(const QString& endpoint) const
+{
+    if (!m_hedgingEnabled) {
+        return 0;
+    }
+    // 样本不足时不对冲
+    const qint64 p95 = getLatencyP95(endpoint);
+    return p95 > 0 ? qMax<qint64>(p95, MIN_HEDGE_DELAY) : 0;
+}
+
+void HttpClient::recordLatency(const QString& endpoint, qint64 milliseconds)
+{
+    auto it = m_latencies.find(endpoint);
+    if (it == m_latencies.end()) {
+        return;
+    }
+
+    // 环形窗口，只保留最近的样本
+    if (it->samples.size() < MAX_LATENCY_SAMPLES) {
+        it->samples.append(milliseconds);
+    } else {
+        it->samples[it->next] = milliseconds;
+        it->next = (it->next + 1) % MAX_LATENCY_SAMPLES;
+    }
+}
+
+void HttpClient::invalidateCache(const QString& path, const QUrlQuery& params)
+{
+    // 使用当前token构造请求，缓存键与 get() 一致
+    m_cache->remove(createRequest(path, params));
+}
+
+QByteArray HttpClient::requestKey(const QByteArray& method, const QNetworkRequest& request) const
+{
+    // 认证头只以摘要形式参与，不同token的请求不会互相合并
+    const QByteArray auth = QCryptographicHash::hash(request.rawHeader("Authorization"),
+                                                     QCryptographicHash::Sha1).toHex();
+    return method + ' ' + request.url().toEncoded() + ' ' + auth;
+}
+
 void HttpClient::onReplyFinished()
 {
     // 已在handleResponse中处理
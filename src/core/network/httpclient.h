@@ -5,12 +5,17 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QSslConfiguration>
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QUrlQuery>
 #include <QFile>
 #include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QDeadlineTimer>
 #include <functional>
+#include "httpcache.h"
 
 namespace Bytedesk {
 
@@ -18,6 +23,45 @@ namespace Bytedesk {
 using HttpCallback = std::function<void(const QJsonObject& response)>;
 using HttpErrorCallback = std::function<void(const QString& error)>;
 
+// 按主机的熔断状态
+enum class HttpCircuitState {
+    CLOSED = 0,     // 正常放行
+    OPEN = 1,       // 连续失败，冷却期内快速失败
+    HALF_OPEN = 2   // 冷却结束，只放行一个探测请求
+};
+
+// 单个请求的耗时分解（毫秒）
+struct HttpRequestTiming {
+    QByteArray method;
+    QString url;
+    int statusCode = 0;
+    bool success = false;
+    bool http2 = false;             // 响应经由HTTP/2
+    bool reusedConnection = false;  // 复用了已有（或预热的）连接
+    qint64 queueMs = 0;             // 发起到开始建连；复用连接时为发起到请求发出
+    qint64 connectMs = 0;           // DNS解析、TCP建连与TLS握手；复用连接时为0
+    qint64 ttfbMs = 0;              // 请求发出到收到响应头
+    qint64 downloadMs = 0;          // 响应头到响应结束
+    qint64 totalMs = 0;
+};
+
+// HTTP客户端统计
+struct HttpClientStats {
+    quint64 requests = 0;       // 发出的网络请求数
+    quint64 getRequests = 0;    // 调用方发起的GET数（含被合并的）
+    quint64 coalescedGets = 0;  // 合并到进行中请求、节省的GET数
+    int inFlightGets = 0;       // 进行中的GET数（合并后）
+    quint64 timeouts = 0;           // 超过请求期限被中止的请求数
+    quint64 hedgedRequests = 0;     // 发出的对冲请求数
+    quint64 hedgeWins = 0;          // 对冲请求先返回的次数
+    quint64 retries = 0;            // 重试次数
+    quint64 circuitRejected = 0;    // 熔断期间快速失败的请求数
+    quint64 circuitOpened = 0;      // 熔断打开次数
+    quint64 preconnects = 0;        // 预热连接次数
+    quint64 reusedConnections = 0;  // 未新建连接的请求数
+    quint64 http2Responses = 0;     // 经由HTTP/2的响应数
+};
+
 // HTTP客户端类
 class HttpClient : public QObject
 {
@@ -27,15 +71,19 @@ public:
     explicit HttpClient(QObject* parent = nullptr);
     ~HttpClient();
 
-    // 设置基础URL
+    // 设置基础URL，同时预热到API主机的连接
     void setBaseUrl(const QString& baseUrl);
     QString getBaseUrl() const { return m_baseUrl; }
 
+    // 提前建立到API主机的连接（DNS、TCP、TLS），之后的请求直接复用
+    void preconnect();
+
     // 设置认证token
     void setAccessToken(const QString& token);
     void clearAccessToken();
 
     // GET请求
+    // 方法、URL和认证相同的GET在进行中时只发一次网络请求，响应解析一次后分发给所有回调
     void get(const QString& path, const QUrlQuery& params = QUrlQuery(),
             HttpCallback onSuccess = nullptr, HttpErrorCallback onError = nullptr);
 
@@ -62,13 +110,40 @@ public:
                  HttpErrorCallback onError = nullptr,
                  std::function<void(qint64 bytesReceived, qint64 bytesTotal)> onProgress = nullptr);
 
-    // 设置超时
+    // 设置默认的请求期限（毫秒）：整个调用（含重试和对冲）的总时长上限，超过后中止并报错
     void setTimeout(int milliseconds) { m_timeout = milliseconds; }
 
+    // 接口的请求期限，按路径最长前缀匹配；未设置的接口使用默认值
+    void setEndpointTimeout(const QString& endpoint, int milliseconds);
+
+    // 对冲：登记的幂等GET接口超过其P95延迟仍未返回时，再发一个相同请求，先成功的生效
+    void setHedgingEnabled(bool enabled) { m_hedgingEnabled = enabled; }
+    void setHedgedEndpoint(const QString& endpoint, bool hedged = true);
+    // 接口最近的P95延迟，样本不足时返回-1
+    qint64 getLatencyP95(const QString& endpoint) const;
+
+    // 重试：GET/PUT/DELETE 遇到网络故障、408/429/502/503/504 时按指数退避加抖动重试，
+    // 429/503 带 Retry-After 时按服务端要求等待。POST不重试
+    void setRetryPolicy(int maxRetries, int baseDelay, int maxDelay);
+
+    // 熔断：同一主机连续失败达到阈值后，冷却期内的请求直接失败，冷却结束后放一个探测请求
+    void setCircuitBreaker(int failureThreshold, int cooldown);
+    HttpCircuitState getCircuitState(const QString& host) const;
+
+    // 响应缓存（登记了策略的GET接口）
+    HttpCache* cache() const { return m_cache; }
+    void invalidateCache(const QString& path, const QUrlQuery& params = QUrlQuery());
+
+    // 统计
+    HttpClientStats getStats() const { return m_stats; }
+
 signals:
     void requestStarted(const QString& url);
     void requestFinished(const QString& url, bool success);
     void networkErrorOccurred(const QString& error);
+    // 每个网络请求结束时发出耗时分解
+    void requestTimed(const HttpRequestTiming& timing);
+    void circuitStateChanged(const QString& host, HttpCircuitState state);
 
 private slots:
     void onReplyFinished();
@@ -80,12 +155,84 @@ private slots:
 private:
     QNetworkRequest createRequest(const QString& path, const QUrlQuery& params = QUrlQuery());
     void handleResponse(QNetworkReply* reply, HttpCallback onSuccess, HttpErrorCallback onError);
+    void handleResponse(QNetworkReply* reply, const QByteArray& data,
+                        HttpCallback onSuccess, HttpErrorCallback onError);
+    void handleSuccess(const QString& url, int statusCode, const QByteArray& data,
+                       HttpCallback onSuccess, HttpErrorCallback onError);
     QString getFullUrl(const QString& path, const QUrlQuery& params = QUrlQuery());
+    void trackRequest(QNetworkReply* reply, const QByteArray& method);
+    void startGetAttempt(const QByteArray& key);
+    void failPendingGet(const QByteArray& key, const QString& error);
+    void sendRequest(const QByteArray& method, std::function<QNetworkReply*()> send,
+                     HttpCallback onSuccess, HttpErrorCallback onError,
+                     const QDeadlineTimer& deadline, int attempt = 0);
+    void enforceDeadline(QNetworkReply* reply, const QDeadlineTimer& deadline);
+    void onGetFinished(const QByteArray& key, QNetworkReply* reply);
+    int timeoutFor(const QString& path) const;
+    qint64 hedgeDelayFor(const QString& endpoint) const;
+    void recordLatency(const QString& endpoint, qint64 milliseconds);
+
+    struct CircuitBreaker {
+        HttpCircuitState state = HttpCircuitState::CLOSED;
+        int failures = 0;           // 连续失败次数
+        bool probeInFlight = false; // 半开状态下的探测请求是否已发出
+        QElapsedTimer openTimer;    // 打开的时间
+    };
+
+    // 返回-1表示不重试
+    qint64 retryDelay(const QByteArray& method, QNetworkReply* reply, int attempt) const;
+    static bool isRetryableError(QNetworkReply* reply);
+    static qint64 parseRetryAfter(const QByteArray& value);
+    bool acquireCircuit(const QString& host);
+    void recordOutcome(QNetworkReply* reply);
+    void setCircuitState(const QString& host, CircuitBreaker& circuit, HttpCircuitState state);
+    QString circuitOpenError(const QUrl& url) const;
+    void rejectRequest(const QUrl& url, HttpErrorCallback onError);
+    QByteArray requestKey(const QByteArray& method, const QNetworkRequest& request) const;
 
     QNetworkAccessManager* m_networkManager;
+    HttpCache* m_cache;
+    QSslConfiguration m_sslConfiguration;
     QString m_baseUrl;
     QString m_accessToken;
     int m_timeout;
+    QHash<QString, int> m_endpointTimeouts;
+    bool m_hedgingEnabled;
+    int m_maxRetries;
+    int m_retryBaseDelay;
+    int m_retryMaxDelay;
+    int m_circuitFailureThreshold;
+    int m_circuitCooldown;
+    QHash<QString, CircuitBreaker> m_circuits;
+    HttpClientStats m_stats;
+
+    // 进行中的GET，键为 requestKey
+    struct PendingGet {
+        QList<HttpCallback> onSuccess;
+        QList<HttpErrorCallback> onError;
+        QString endpoint;
+        QNetworkRequest request;
+        bool hasCached = false;
+        HttpCache::Entry cached;          // 条件请求返回304时使用
+        QList<QNetworkReply*> replies;    // 原始请求，以及可能的对冲请求
+        QTimer* hedgeTimer = nullptr;
+        int attempts = 0;                 // 已重试次数
+        QHash<QNetworkReply*, QElapsedTimer> attemptTimers; // 每次请求（含对冲）各自的发起时间
+        QDeadlineTimer deadline;          // 整个调用的期限，重试和对冲都不能超过
+    };
+    QHash<QByteArray, PendingGet> m_pendingGets;
+
+    // 对冲接口的最近延迟样本
+    struct LatencyWindow {
+        QList<qint64> samples;
+        int next = 0;
+    };
+    QHash<QString, LatencyWindow> m_latencies;
+
+    static const int MAX_LATENCY_SAMPLES = 64;
+    static const int MIN_LATENCY_SAMPLES = 20;
+    static const int MIN_HEDGE_DELAY = 50;
+    static const int MAX_RETRY_AFTER = 60000;   // Retry-After 超过该值时不再等待
 
     // 下载相关
     struct DownloadInfo {
@@ -6,6 +6,14 @@ namespace Bytedesk {
 MessageApi::MessageApi(HttpClient* httpClient, QObject* parent)
     : ApiBase(httpClient, parent)
 {
+    // 消息分页：每次都条件请求，历史页基本不变，多数返回304
+    httpClient->cache()->setPolicy(m_apiPath, 0);
+    httpClient->cache()->setPolicy(m_apiPath + "/thread/topic", 0);
+
+    // 消息分页是幂等GET，启用对冲
+    httpClient->setEndpointTimeout(m_apiPath, 10000);
+    httpClient->setHedgedEndpoint(m_apiPath);
+    httpClient->setHedgedEndpoint(m_apiPath + "/thread/topic");
 }
 
 MessageApi::~MessageApi()
@@ -227,6 +235,40 @@ void MessageApi::markAsRead(const QString& threadUid, const QString& messageUid,
     );
 }
 
+void MessageApi::markThreadRead(const QString& threadUid, const QString& messageUid,
+                                const QDateTime& readUpTo, std::function<void(bool)> callback)
+{
+    qDebug() << "Mark thread as read:" << threadUid << "up to:" << messageUid;
+
+    QJsonObject request;
+    request["threadUid"] = threadUid;
+    request["messageUid"] = messageUid;
+    request["readUpTo"] = readUpTo.toString(Qt::ISODateWithMs);
+
+    httpClient()->post(m_apiPath + "/read/thread", request,
+        [this, callback](const QJsonObject& response) {
+            bool success = isResponseSuccess(response);
+
+            if (!success) {
+                QString message = getResponseMessage(response);
+                qWarning() << "Failed to mark thread as read:" << message;
+            }
+
+            if (callback) {
+                callback(success);
+            }
+        },
+        [this, callback](const QString& error) {
+            qWarning() << "Mark thread as read network error:" << error;
+            handleNetworkError(error);
+
+            if (callback) {
+                callback(false);
+            }
+        }
+    );
+}
+
 void MessageApi::getUnreadCount(std::function<void(int)> callback,
                                std::function<void(const QString&)> onError)
 {
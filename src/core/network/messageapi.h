@@ -129,6 +129,10 @@ public:
     void markAsRead(const QString& threadUid, const QString& messageUid,
                    std::function<void(bool success)> callback);
 
+    // 标记会话已读到 messageUid（创建时间 readUpTo）为止，一次请求覆盖之前的所有消息
+    void markThreadRead(const QString& threadUid, const QString& messageUid, const QDateTime& readUpTo,
+                       std::function<void(bool success)> callback);
+
     // 获取未读消息数
     void getUnreadCount(std::function<void(int count)> callback,
                        std::function<void(const QString& error)> onError = nullptr);
@@ -6,6 +6,12 @@ namespace Bytedesk {
 ThreadApi::ThreadApi(HttpClient* httpClient, QObject* parent)
     : ApiBase(httpClient, parent)
 {
+    // 会话列表变化频繁：每次都条件请求，未变化时服务端返回304
+    httpClient->cache()->setPolicy(m_apiPath + "/list", 0);
+
+    // 切换会话依赖列表加载，期限更短并启用对冲
+    httpClient->setEndpointTimeout(m_apiPath, 10000);
+    httpClient->setHedgedEndpoint(m_apiPath + "/list");
 }
 
 ThreadApi::~ThreadApi()
@@ -0,0 +1,455 @@
+#include "protobufwrapper.h"
+#include <QDebug>
+
+#ifdef BYTEDESK_WITH_PROTOBUF
+#include "message.pb.h"
+#include "thread.pb.h"
+#include "user.pb.h"
+#include <google/protobuf/arena.h>
+#include <cstdlib>
+#endif
+
+namespace Bytedesk {
+
+namespace {
+
+// 载荷首字节的Protobuf标签：(字段号 << 3) | 2（长度分隔类型）
+constexpr char MESSAGE_UID_TAG = 0x0A;      // Message.uid，字段1
+constexpr char BATCH_MESSAGES_TAG = 0x7A;   // MessageBatch.messages，字段15
+
+} // namespace
+
+#ifdef BYTEDESK_WITH_PROTOBUF
+
+namespace {
+
+// 消息来源客户端
+const char* const CHANNEL_DESKTOP = "DESKTOP";
+
+inline void setString(std::string* target, const QString& value)
+{
+    const QByteArray utf8 = value.toUtf8();
+    target->assign(utf8.constData(), static_cast<size_t>(utf8.size()));
+}
+
+// 枚举名称是静态Latin-1数据，直接拷贝字节
+inline void setString(std::string* target, QLatin1String value)
+{
+    target->assign(value.data(), static_cast<size_t>(value.size()));
+}
+
+inline QString toQString(const std::string& value)
+{
+    return QString::fromUtf8(value.data(), static_cast<qsizetype>(value.size()));
+}
+
+inline QByteArrayView toView(const std::string& value)
+{
+    return QByteArrayView(value.data(), static_cast<qsizetype>(value.size()));
+}
+
+// Arena 申请新内存块的计数（按线程统计，解码器在单线程内使用）
+thread_local quint64 t_arenaBlockAllocations = 0;
+
+void* countingBlockAlloc(size_t size)
+{
+    ++t_arenaBlockAllocations;
+    return std::malloc(size);
+}
+
+void countingBlockDealloc(void* block, size_t)
+{
+    std::free(block);
+}
+
+QByteArray serializeToByteArray(const google::protobuf::MessageLite& proto)
+{
+    // 按序列化后的精确大小一次性分配
+    QByteArray data(static_cast<qsizetype>(proto.ByteSizeLong()), Qt::Uninitialized);
+    if (!proto.SerializeToArray(data.data(), static_cast<int>(data.size()))) {
+        return QByteArray();
+    }
+    return data;
+}
+
+void userToProto(const User& user, ::User* proto)
+{
+    setString(proto->mutable_uid(), user.getUid());
+    setString(proto->mutable_nickname(), user.getNickname());
+    setString(proto->mutable_avatar(), user.getAvatar());
+    setString(proto->mutable_type(), User::typeName(user.getType()));
+}
+
+void userFromProto(const ::User& proto, User& user)
+{
+    user.setUid(toQString(proto.uid()));
+    user.setNickname(toQString(proto.nickname()));
+    user.setAvatar(toQString(proto.avatar()));
+    if (!proto.type().empty()) {
+        user.setTypeUtf8(toView(proto.type()));
+    }
+}
+
+void threadToProto(const Thread& thread, ::Thread* proto)
+{
+    setString(proto->mutable_uid(), thread.getUid());
+    setString(proto->mutable_topic(), thread.getTopic());
+    setString(proto->mutable_type(), Thread::typeName(thread.getType()));
+    setString(proto->mutable_state(), Thread::statusName(thread.getStatus()));
+    proto->set_channel(CHANNEL_DESKTOP);
+}
+
+void threadFromProto(const ::Thread& proto, Thread& thread)
+{
+    thread.setUid(toQString(proto.uid()));
+    thread.setTopic(toQString(proto.topic()));
+    if (!proto.type().empty()) {
+        thread.setTypeUtf8(toView(proto.type()));
+    }
+    if (!proto.state().empty()) {
+        thread.setStatusUtf8(toView(proto.state()));
+    }
+    if (proto.has_user()) {
+        thread.setTitle(toQString(proto.user().nickname()));
+        thread.setAvatar(toQString(proto.user().avatar()));
+    }
+}
+
+void messageToProto(const Message& message, ::Message* proto)
+{
+    setString(proto->mutable_uid(), message.getUid());
+    setString(proto->mutable_type(), Message::typeName(message.getType()));
+    setString(proto->mutable_content(), message.getContentString());
+    setString(proto->mutable_status(), Message::statusName(message.getStatus()));
+    setString(proto->mutable_createdat(), message.getCreatedAt().toString(Qt::ISODate));
+    proto->set_channel(CHANNEL_DESKTOP);
+
+    if (!message.getThreadUid().isEmpty()) {
+        setString(proto->mutable_thread()->mutable_uid(), message.getThreadUid());
+    }
+
+    ::User* user = proto->mutable_user();
+    setString(user->mutable_uid(), message.getUserUid());
+    setString(user->mutable_nickname(), message.getUserName());
+    setString(user->mutable_avatar(), message.getUserAvatar());
+
+    if (!message.getExtra().isEmpty()) {
+        setString(proto->mutable_extra(), message.getExtra());
+    }
+}
+
+void messageFromProto(const ::Message& proto, Message& message)
+{
+    message.setUid(toQString(proto.uid()));
+    message.setTypeUtf8(toView(proto.type()));
+    // 内容按原始UTF-8保存，读取字段时才解码
+    message.setContentUtf8(toView(proto.content()));
+    if (!proto.status().empty()) {
+        message.setStatusUtf8(toView(proto.status()));
+    }
+    if (!proto.createdat().empty()) {
+        message.setCreatedAt(QDateTime::fromString(toQString(proto.createdat()), Qt::ISODate));
+    }
+    if (proto.has_thread()) {
+        message.setThreadUid(toQString(proto.thread().uid()));
+    }
+    if (proto.has_user()) {
+        message.setUserUid(toQString(proto.user().uid()));
+        message.setUserName(toQString(proto.user().nickname()));
+        message.setUserAvatar(toQString(proto.user().avatar()));
+    }
+    message.setExtra(toQString(proto.extra()));
+}
+
+void messagesFromProto(const ::MessageBatch& proto, QList<MessagePtr>& messages)
+{
+    messages.reserve(messages.size() + proto.messages_size());
+    for (const ::Message& item : proto.messages()) {
+        MessagePtr message = QSharedPointer<Message>::create();
+        messageFromProto(item, *message);
+        messages.append(message);
+    }
+}
+
+} // namespace
+
+bool ProtobufWrapper::isAvailable()
+{
+    return true;
+}
+
+QByteArray ProtobufWrapper::serializeMessage(const Message& message)
+{
+    ::Message proto;
+    messageToProto(message, &proto);
+    return serializeToByteArray(proto);
+}
+
+bool ProtobufWrapper::parseMessage(QByteArrayView data, Message& message)
+{
+    ::Message proto;
+    if (!proto.ParseFromArray(data.data(), static_cast<int>(data.size()))) {
+        qWarning() << "Failed to parse protobuf message, size:" << data.size();
+        return false;
+    }
+    messageFromProto(proto, message);
+    return true;
+}
+
+QByteArray ProtobufWrapper::serializeMessageBatch(const QList<MessagePtr>& messages)
+{
+    ::MessageBatch proto;
+    proto.mutable_messages()->Reserve(static_cast<int>(messages.size()));
+    for (const MessagePtr& message : messages) {
+        messageToProto(*message, proto.add_messages());
+    }
+    return serializeToByteArray(proto);
+}
+
+bool ProtobufWrapper::parseMessageBatch(QByteArrayView data, QList<MessagePtr>& messages)
+{
+    ::MessageBatch proto;
+    if (!proto.ParseFromArray(data.data(), static_cast<int>(data.size()))) {
+        qWarning() << "Failed to parse protobuf message batch, size:" << data.size();
+        return false;
+    }
+    messagesFromProto(proto, messages);
+    return true;
+}
+
+QByteArray ProtobufWrapper::serializeThread(const Thread& thread)
+{
+    ::Thread proto;
+    threadToProto(thread, &proto);
+    return serializeToByteArray(proto);
+}
+
+bool ProtobufWrapper::parseThread(QByteArrayView data, Thread& thread)
+{
+    ::Thread proto;
+    if (!proto.ParseFromArray(data.data(), static_cast<int>(data.size()))) {
+        qWarning() << "Failed to parse protobuf thread, size:" << data.size();
+        return false;
+    }
+    threadFromProto(proto, thread);
+    return true;
+}
+
+QByteArray ProtobufWrapper::serializeUser(const User& user)
+{
+    ::User proto;
+    userToProto(user, &proto);
+    return serializeToByteArray(proto);
+}
+
+bool ProtobufWrapper::parseUser(QByteArrayView data, User& user)
+{
+    ::User proto;
+    if (!proto.ParseFromArray(data.data(), static_cast<int>(data.size()))) {
+        qWarning() << "Failed to parse protobuf user, size:" << data.size();
+        return false;
+    }
+    userFromProto(proto, user);
+    return true;
+}
+
+struct ProtobufDecoder::Impl {
+    std::unique_ptr<char[]> initialBlock;
+    std::unique_ptr<google::protobuf::Arena> arena;
+    ProtobufDecodeStats stats;
+
+    explicit Impl(int initialBlockSize)
+        : initialBlock(new char[initialBlockSize])
+    {
+        google::protobuf::ArenaOptions options;
+        options.initial_block = initialBlock.get();
+        options.initial_block_size = static_cast<size_t>(initialBlockSize);
+        options.block_alloc = &countingBlockAlloc;
+        options.block_dealloc = &countingBlockDealloc;
+        arena.reset(new google::protobuf::Arena(options));
+    }
+};
+
+ProtobufDecoder::ProtobufDecoder(int initialBlockSize)
+    : m_impl(new Impl(qMax(1024, initialBlockSize)))
+{
+}
+
+ProtobufDecoder::~ProtobufDecoder() = default;
+
+bool ProtobufDecoder::decode(QByteArrayView data, Message& message)
+{
+    const quint64 blocksBefore = t_arenaBlockAllocations;
+
+    // 对象随Arena一起释放，不需要单独析构
+    ::Message* proto = google::protobuf::Arena::CreateMessage<::Message>(m_impl->arena.get());
+    const bool ok = proto->ParseFromArray(data.data(), static_cast<int>(data.size()));
+
+    m_impl->stats.arenaBlockAllocations += t_arenaBlockAllocations - blocksBefore;
+    if (!ok) {
+        m_impl->stats.failed++;
+        qWarning() << "Failed to parse protobuf message, size:" << data.size();
+        return false;
+    }
+
+    messageFromProto(*proto, message);
+    m_impl->stats.decoded++;
+    return true;
+}
+
+bool ProtobufDecoder::decodeBatch(QByteArrayView data, QList<MessagePtr>& messages)
+{
+    const quint64 blocksBefore = t_arenaBlockAllocations;
+
+    ::MessageBatch* proto = google::protobuf::Arena::CreateMessage<::MessageBatch>(m_impl->arena.get());
+    const bool ok = proto->ParseFromArray(data.data(), static_cast<int>(data.size()));
+
+    m_impl->stats.arenaBlockAllocations += t_arenaBlockAllocations - blocksBefore;
+    if (!ok) {
+        m_impl->stats.failed++;
+        qWarning() << "Failed to parse protobuf message batch, size:" << data.size();
+        return false;
+    }
+
+    messagesFromProto(*proto, messages);
+    m_impl->stats.decoded += static_cast<quint64>(proto->messages_size());
+    return true;
+}
+
+void ProtobufDecoder::reset()
+{
+    const quint64 used = m_impl->arena->SpaceUsed();
+    if (used == 0) {
+        return;
+    }
+    m_impl->stats.maxBatchArenaBytes = qMax<quint64>(m_impl->stats.maxBatchArenaBytes, used);
+    m_impl->stats.batches++;
+    m_impl->arena->Reset();
+}
+
+ProtobufDecodeStats ProtobufDecoder::getStats() const
+{
+    return m_impl->stats;
+}
+
+#else // BYTEDESK_WITH_PROTOBUF
+
+struct ProtobufDecoder::Impl {
+    ProtobufDecodeStats stats;
+};
+
+ProtobufDecoder::ProtobufDecoder(int)
+    : m_impl(new Impl)
+{
+}
+
+ProtobufDecoder::~ProtobufDecoder() = default;
+
+bool ProtobufDecoder::decode(QByteArrayView, Message&)
+{
+    m_impl->stats.failed++;
+    return false;
+}
+
+bool ProtobufDecoder::decodeBatch(QByteArrayView, QList<MessagePtr>&)
+{
+    m_impl->stats.failed++;
+    return false;
+}
+
+void ProtobufDecoder::reset()
+{
+}
+
+ProtobufDecodeStats ProtobufDecoder::getStats() const
+{
+    return m_impl->stats;
+}
+
+bool ProtobufWrapper::isAvailable()
+{
+    return false;
+}
+
+QByteArray ProtobufWrapper::serializeMessage(const Message&)
+{
+    return QByteArray();
+}
+
+bool ProtobufWrapper::parseMessage(QByteArrayView, Message&)
+{
+    return false;
+}
+
+QByteArray ProtobufWrapper::serializeMessageBatch(const QList<MessagePtr>&)
+{
+    return QByteArray();
+}
+
+bool ProtobufWrapper::parseMessageBatch(QByteArrayView, QList<MessagePtr>&)
+{
+    return false;
+}
+
+QByteArray ProtobufWrapper::serializeThread(const Thread&)
+{
+    return QByteArray();
+}
+
+bool ProtobufWrapper::parseThread(QByteArrayView, Thread&)
+{
+    return false;
+}
+
+QByteArray ProtobufWrapper::serializeUser(const User&)
+{
+    return QByteArray();
+}
+
+bool ProtobufWrapper::parseUser(QByteArrayView, User&)
+{
+    return false;
+}
+
+#endif // BYTEDESK_WITH_PROTOBUF
+
+bool ProtobufWrapper::looksLikeJson(QByteArrayView payload)
+{
+    if (payload.isEmpty()) {
+        return false;
+    }
+    // 先按首字节判断Protobuf：0x0A（Message.uid 的标签）同时也是换行符，
+    // 跳过空白会把它吞掉，改由uid长度和首字符决定格式
+    if (payload.front() == MESSAGE_UID_TAG || payload.front() == BATCH_MESSAGES_TAG) {
+        return false;
+    }
+    for (char ch : payload) {
+        if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+            continue;
+        }
+        return ch == '{' || ch == '[';
+    }
+    return false;
+}
+
+bool ProtobufWrapper::isMessageBatch(QByteArrayView payload)
+{
+    if (payload.isEmpty()) {
+        return false;
+    }
+    if (payload.front() == BATCH_MESSAGES_TAG) {
+        return true;
+    }
+    if (payload.front() == MESSAGE_UID_TAG) {
+        return false;
+    }
+    for (char ch : payload) {
+        if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+            continue;
+        }
+        return ch == '[';
+    }
+    return false;
+}
+
+} // namespace Bytedesk
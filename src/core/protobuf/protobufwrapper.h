@@ -0,0 +1,100 @@
+#ifndef PROTOBUFWRAPPER_H
+#define PROTOBUFWRAPPER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <memory>
+#include "models/message.h"
+#include "models/thread.h"
+#include "models/user.h"
+
+namespace Bytedesk {
+
+// Protobuf编解码封装
+// 在 Bytedesk::Message/Thread/User 与 proto/*.proto 生成的类型之间转换。
+// 生成的类型没有package，位于全局命名空间，因此只在实现文件中引用；
+// 未定义 BYTEDESK_WITH_PROTOBUF 时所有接口返回失败，调用方回退到JSON
+class ProtobufWrapper
+{
+public:
+    // 是否编译了Protobuf支持
+    static bool isAvailable();
+
+    // 入站载荷格式探测：首字节为 0x0A（Message.uid）或 0x7A（MessageBatch）时直接视为Protobuf；
+    // 否则首个非空白字节为 '{' 或 '[' 视为JSON
+    // （'{' = 0x7B 对应字段15的 start-group，不会出现在我们的proto3消息中）
+    static bool looksLikeJson(QByteArrayView payload);
+
+    // 批量信封：Protobuf 的 MessageBatch（首字节 0x7A）或 JSON 数组
+    static bool isMessageBatch(QByteArrayView payload);
+
+    // Message
+    static QByteArray serializeMessage(const Message& message);
+    static bool parseMessage(QByteArrayView data, Message& message);
+
+    // MessageBatch：多条消息共用一个载荷
+    static QByteArray serializeMessageBatch(const QList<MessagePtr>& messages);
+    static bool parseMessageBatch(QByteArrayView data, QList<MessagePtr>& messages);
+
+    // Thread
+    static QByteArray serializeThread(const Thread& thread);
+    static bool parseThread(QByteArrayView data, Thread& thread);
+
+    // User
+    static QByteArray serializeUser(const User& user);
+    static bool parseUser(QByteArrayView data, User& user);
+};
+
+// 入站解码统计
+struct ProtobufDecodeStats {
+    quint64 decoded = 0;                // 成功解码的消息数
+    quint64 failed = 0;
+    quint64 batches = 0;                // reset() 次数，即处理过的 readyRead 批次
+    quint64 arenaBlockAllocations = 0;  // Arena 向堆申请新内存块的次数（复用的初始块不计）
+    quint64 maxBatchArenaBytes = 0;     // 单批次占用的最大Arena空间
+
+    double blockAllocationsPerMessage() const {
+        return decoded > 0 ? static_cast<double>(arenaBlockAllocations) / static_cast<double>(decoded) : 0.0;
+    }
+
+    // 合并多个解码器的统计
+    void merge(const ProtobufDecodeStats& other) {
+        decoded += other.decoded;
+        failed += other.failed;
+        batches += other.batches;
+        arenaBlockAllocations += other.arenaBlockAllocations;
+        maxBatchArenaBytes = qMax(maxBatchArenaBytes, other.maxBatchArenaBytes);
+    }
+};
+
+// 入站热路径的Protobuf解码器
+// proto对象（含嵌套的Thread/User）分配在Arena上，Arena带一块复用的初始内存；
+// 每批 readyRead 结束时调用 reset() 统一回收，突发消息在初始块内解码时不再逐条申请堆内存。
+// 非线程安全，每个处理线程持有一个实例
+class ProtobufDecoder
+{
+public:
+    explicit ProtobufDecoder(int initialBlockSize = 64 * 1024);
+    ~ProtobufDecoder();
+
+    ProtobufDecoder(const ProtobufDecoder&) = delete;
+    ProtobufDecoder& operator=(const ProtobufDecoder&) = delete;
+
+    bool decode(QByteArrayView data, Message& message);
+    // 解码 MessageBatch，结果追加到 messages
+    bool decodeBatch(QByteArrayView data, QList<MessagePtr>& messages);
+
+    // 回收本批次在Arena上分配的对象，保留初始块
+    void reset();
+
+    ProtobufDecodeStats getStats() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+} // namespace Bytedesk
+
+#endif // PROTOBUFWRAPPER_H
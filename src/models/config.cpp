@@ -281,6 +281,16 @@ void Config::setMqttReconnectPeriod(int milliseconds)
     m_settings->setValue("mqtt/reconnectPeriod", milliseconds);
 }
 
+int Config::getMqttMaxReconnectDelay() const
+{
+    return m_settings->value("mqtt/maxReconnectDelay", DEFAULT_MQTT_MAX_RECONNECT_DELAY).toInt();
+}
+
+void Config::setMqttMaxReconnectDelay(int milliseconds)
+{
+    m_settings->setValue("mqtt/maxReconnectDelay", milliseconds);
+}
+
 int Config::getMqttConnectTimeout() const
 {
     return m_settings->value("mqtt/connectTimeout", DEFAULT_MQTT_CONNECT_TIMEOUT).toInt();
@@ -291,6 +301,16 @@ void Config::setMqttConnectTimeout(int milliseconds)
     m_settings->setValue("mqtt/connectTimeout", milliseconds);
 }
 
+int Config::getMqttPingTimeout() const
+{
+    return m_settings->value("mqtt/pingTimeout", DEFAULT_MQTT_PING_TIMEOUT).toInt();
+}
+
+void Config::setMqttPingTimeout(int milliseconds)
+{
+    m_settings->setValue("mqtt/pingTimeout", milliseconds);
+}
+
 bool Config::getMqttCleanSession() const
 {
     return m_settings->value("mqtt/cleanSession", DEFAULT_MQTT_CLEAN_SESSION).toBool();
@@ -301,6 +321,196 @@ void Config::setMqttCleanSession(bool clean)
     m_settings->setValue("mqtt/cleanSession", clean);
 }
 
+int Config::getMqttWriteCoalescing() const
+{
+    return m_settings->value("mqtt/writeCoalescing", DEFAULT_MQTT_WRITE_COALESCING).toInt();
+}
+
+void Config::setMqttWriteCoalescing(int microseconds)
+{
+    m_settings->setValue("mqtt/writeCoalescing", microseconds);
+}
+
+int Config::getMqttWriteBufferSize() const
+{
+    return m_settings->value("mqtt/writeBufferSize", DEFAULT_MQTT_WRITE_BUFFER_SIZE).toInt();
+}
+
+void Config::setMqttWriteBufferSize(int bytes)
+{
+    m_settings->setValue("mqtt/writeBufferSize", bytes);
+}
+
+bool Config::getMqttUseProtobuf() const
+{
+    return m_settings->value("mqtt/useProtobuf", DEFAULT_MQTT_USE_PROTOBUF).toBool();
+}
+
+void Config::setMqttUseProtobuf(bool enabled)
+{
+    m_settings->setValue("mqtt/useProtobuf", enabled);
+}
+
+bool Config::getMqttBatchEnvelope() const
+{
+    return m_settings->value("mqtt/batchEnvelope", DEFAULT_MQTT_BATCH_ENVELOPE).toBool();
+}
+
+void Config::setMqttBatchEnvelope(bool enabled)
+{
+    m_settings->setValue("mqtt/batchEnvelope", enabled);
+}
+
+int Config::getMqttDedupCapacity() const
+{
+    return m_settings->value("mqtt/dedupCapacity", DEFAULT_MQTT_DEDUP_CAPACITY).toInt();
+}
+
+void Config::setMqttDedupCapacity(int capacity)
+{
+    m_settings->setValue("mqtt/dedupCapacity", capacity);
+}
+
+int Config::getMqttReadWatermarkWindow() const
+{
+    return m_settings->value("mqtt/readWatermarkWindow", DEFAULT_MQTT_READ_WATERMARK_WINDOW).toInt();
+}
+
+void Config::setMqttReadWatermarkWindow(int milliseconds)
+{
+    m_settings->setValue("mqtt/readWatermarkWindow", milliseconds);
+}
+
+int Config::getMqttDecodeParallelism() const
+{
+    return m_settings->value("mqtt/decodeParallelism", DEFAULT_MQTT_DECODE_PARALLELISM).toInt();
+}
+
+void Config::setMqttDecodeParallelism(int parallelism)
+{
+    m_settings->setValue("mqtt/decodeParallelism", parallelism);
+}
+
+int Config::getMqttTypingInterval() const
+{
+    return m_settings->value("mqtt/typingInterval", DEFAULT_MQTT_TYPING_INTERVAL).toInt();
+}
+
+void Config::setMqttTypingInterval(int milliseconds)
+{
+    m_settings->setValue("mqtt/typingInterval", milliseconds);
+}
+
+int Config::getMqttTypingIdleTimeout() const
+{
+    return m_settings->value("mqtt/typingIdleTimeout", DEFAULT_MQTT_TYPING_IDLE_TIMEOUT).toInt();
+}
+
+void Config::setMqttTypingIdleTimeout(int milliseconds)
+{
+    m_settings->setValue("mqtt/typingIdleTimeout", milliseconds);
+}
+
+int Config::getMqttTypingExpiry() const
+{
+    return m_settings->value("mqtt/typingExpiry", DEFAULT_MQTT_TYPING_EXPIRY).toInt();
+}
+
+void Config::setMqttTypingExpiry(int milliseconds)
+{
+    m_settings->setValue("mqtt/typingExpiry", milliseconds);
+}
+
+bool Config::getMqttNetworkThread() const
+{
+    return m_settings->value("mqtt/networkThread", DEFAULT_MQTT_NETWORK_THREAD).toBool();
+}
+
+void Config::setMqttNetworkThread(bool enabled)
+{
+    m_settings->setValue("mqtt/networkThread", enabled);
+}
+
+int Config::getMqttBridgeCapacity() const
+{
+    return m_settings->value("mqtt/bridgeCapacity", DEFAULT_MQTT_BRIDGE_CAPACITY).toInt();
+}
+
+void Config::setMqttBridgeCapacity(int capacity)
+{
+    m_settings->setValue("mqtt/bridgeCapacity", capacity);
+}
+
+bool Config::getHttpCacheEnabled() const
+{
+    return m_settings->value("http/cacheEnabled", DEFAULT_HTTP_CACHE_ENABLED).toBool();
+}
+
+void Config::setHttpCacheEnabled(bool enabled)
+{
+    m_settings->setValue("http/cacheEnabled", enabled);
+}
+
+int Config::getHttpCacheMaxSize() const
+{
+    return m_settings->value("http/cacheMaxSize", DEFAULT_HTTP_CACHE_MAX_SIZE).toInt();
+}
+
+void Config::setHttpCacheMaxSize(int megabytes)
+{
+    m_settings->setValue("http/cacheMaxSize", megabytes);
+}
+
+int Config::getHttpRequestTimeout() const
+{
+    return m_settings->value("http/requestTimeout", DEFAULT_HTTP_REQUEST_TIMEOUT).toInt();
+}
+
+void Config::setHttpRequestTimeout(int milliseconds)
+{
+    m_settings->setValue("http/requestTimeout", milliseconds);
+}
+
+bool Config::getHttpHedging() const
+{
+    return m_settings->value("http/hedging", DEFAULT_HTTP_HEDGING).toBool();
+}
+
+void Config::setHttpHedging(bool enabled)
+{
+    m_settings->setValue("http/hedging", enabled);
+}
+
+int Config::getHttpMaxRetries() const
+{
+    return m_settings->value("http/maxRetries", DEFAULT_HTTP_MAX_RETRIES).toInt();
+}
+
+void Config::setHttpMaxRetries(int retries)
+{
+    m_settings->setValue("http/maxRetries", retries);
+}
+
+int Config::getHttpCircuitFailureThreshold() const
+{
+    return m_settings->value("http/circuitFailureThreshold", DEFAULT_HTTP_CIRCUIT_FAILURE_THRESHOLD).toInt();
+}
+
+void Config::setHttpCircuitFailureThreshold(int failures)
+{
+    m_settings->setValue("http/circuitFailureThreshold", failures);
+}
+
+int Config::getHttpCircuitCooldown() const
+{
+    return m_settings->value("http/circuitCooldown", DEFAULT_HTTP_CIRCUIT_COOLDOWN).toInt();
+}
+
+void Config::setHttpCircuitCooldown(int milliseconds)
+{
+    m_settings->setValue("http/circuitCooldown", milliseconds);
+}
+
 void Config::clearUserData()
 {
     m_settings->remove("user");
@@ -321,6 +531,17 @@ void Config::load()
     // QSettings自动加载，这里可以做一些额外的初始化
 }
 
+QString Config::getDeviceUid() const
+{
+    QString uid = m_settings->value("device/uid").toString();
+    if (uid.isEmpty()) {
+        uid = QUuid::createUuid().toString(QUuid::WithoutBraces);
+        m_settings->setValue("device/uid", uid);
+        m_settings->sync();
+    }
+    return uid;
+}
+
 QString Config::generateMqttClientId(const QString& userUid, const QString& deviceUid) const
 {
     if (deviceUid.isEmpty()) {
@@ -81,18 +81,100 @@ public:
     int getMqttReconnectPeriod() const;
     void setMqttReconnectPeriod(int milliseconds);
 
+    // 指数退避的最大重连间隔
+    int getMqttMaxReconnectDelay() const;
+    void setMqttMaxReconnectDelay(int milliseconds);
+
     int getMqttConnectTimeout() const;
     void setMqttConnectTimeout(int milliseconds);
 
+    // 发出PINGREQ后等待PINGRESP的截止时间
+    int getMqttPingTimeout() const;
+    void setMqttPingTimeout(int milliseconds);
+
     bool getMqttCleanSession() const;
     void setMqttCleanSession(bool clean);
 
+    // 出站合并写：同一轮事件循环（或该预算微秒内）的报文合并为一次socket写；0为本轮结束时写出
+    int getMqttWriteCoalescing() const;
+    void setMqttWriteCoalescing(int microseconds);
+
+    // 合并写缓冲超过该字节数时立即写出
+    int getMqttWriteBufferSize() const;
+    void setMqttWriteBufferSize(int bytes);
+
+    // 出站消息使用Protobuf编码（入站自动识别）
+    bool getMqttUseProtobuf() const;
+    void setMqttUseProtobuf(bool enabled);
+
+    // 批量发送时多条消息合并为一个信封（需要服务端支持）
+    bool getMqttBatchEnvelope() const;
+    void setMqttBatchEnvelope(bool enabled);
+
+    // 消息与回执去重缓存的容量（条目数）
+    int getMqttDedupCapacity() const;
+    void setMqttDedupCapacity(int capacity);
+
+    // 已读水位合并窗口
+    int getMqttReadWatermarkWindow() const;
+    void setMqttReadWatermarkWindow(int milliseconds);
+
+    // 入站并行解码的线程数：0 为同步解码，小于0 使用CPU核心数
+    int getMqttDecodeParallelism() const;
+    void setMqttDecodeParallelism(int parallelism);
+
+    // 正在输入：发送间隔、停止输入后发送停止事件的空闲时间、对方输入状态的过期时间
+    int getMqttTypingInterval() const;
+    void setMqttTypingInterval(int milliseconds);
+    int getMqttTypingIdleTimeout() const;
+    void setMqttTypingIdleTimeout(int milliseconds);
+    int getMqttTypingExpiry() const;
+    void setMqttTypingExpiry(int milliseconds);
+
+    // 在独立网络线程中运行MQTT客户端和消息解析
+    bool getMqttNetworkThread() const;
+    void setMqttNetworkThread(bool enabled);
+
+    // 网络线程交给UI线程的消息队列容量
+    int getMqttBridgeCapacity() const;
+    void setMqttBridgeCapacity(int capacity);
+
+    // HTTP配置
+    // REST响应的磁盘缓存（ETag/Last-Modified 重新验证）
+    bool getHttpCacheEnabled() const;
+    void setHttpCacheEnabled(bool enabled);
+
+    // 磁盘缓存容量（MB）
+    int getHttpCacheMaxSize() const;
+    void setHttpCacheMaxSize(int megabytes);
+
+    // 默认请求期限（未单独设置期限的接口）
+    int getHttpRequestTimeout() const;
+    void setHttpRequestTimeout(int milliseconds);
+
+    // 对冲请求：登记的幂等GET超过P95延迟后再发一个相同请求
+    bool getHttpHedging() const;
+    void setHttpHedging(bool enabled);
+
+    // 幂等请求的最大重试次数
+    int getHttpMaxRetries() const;
+    void setHttpMaxRetries(int retries);
+
+    // 熔断：连续失败次数阈值和冷却时间
+    int getHttpCircuitFailureThreshold() const;
+    void setHttpCircuitFailureThreshold(int failures);
+    int getHttpCircuitCooldown() const;
+    void setHttpCircuitCooldown(int milliseconds);
+
     // 工具方法
     void clearUserData();
     void clearAll();
     void save();
     void load();
 
+    // 设备ID：首次调用时生成并保存，登出后保持不变，保证MQTT客户端ID稳定（持久会话依赖于此）
+    QString getDeviceUid() const;
+
     // 生成MQTT客户端ID
     QString generateMqttClientId(const QString& userUid, const QString& deviceUid) const;
 
@@ -112,8 +194,29 @@ private:
     static const QString DEFAULT_MQTT_PATH;
     static const int DEFAULT_MQTT_KEEP_ALIVE = 60;
     static const int DEFAULT_MQTT_RECONNECT_PERIOD = 3000;
+    static const int DEFAULT_MQTT_MAX_RECONNECT_DELAY = 60000;
     static const int DEFAULT_MQTT_CONNECT_TIMEOUT = 30000;
+    static const int DEFAULT_MQTT_PING_TIMEOUT = 10000;
     static const bool DEFAULT_MQTT_CLEAN_SESSION = false;
+    static const int DEFAULT_MQTT_WRITE_COALESCING = 0;
+    static const int DEFAULT_MQTT_WRITE_BUFFER_SIZE = 64 * 1024;
+    static const bool DEFAULT_MQTT_USE_PROTOBUF = false;
+    static const bool DEFAULT_MQTT_BATCH_ENVELOPE = false;
+    static const int DEFAULT_MQTT_DEDUP_CAPACITY = 4096;
+    static const int DEFAULT_MQTT_READ_WATERMARK_WINDOW = 500;
+    static const int DEFAULT_MQTT_DECODE_PARALLELISM = 0;
+    static const int DEFAULT_MQTT_TYPING_INTERVAL = 3000;
+    static const int DEFAULT_MQTT_TYPING_IDLE_TIMEOUT = 5000;
+    static const int DEFAULT_MQTT_TYPING_EXPIRY = 6000;
+    static const bool DEFAULT_MQTT_NETWORK_THREAD = false;
+    static const int DEFAULT_MQTT_BRIDGE_CAPACITY = 4096;
+    static const bool DEFAULT_HTTP_CACHE_ENABLED = true;
+    static const int DEFAULT_HTTP_CACHE_MAX_SIZE = 50;
+    static const int DEFAULT_HTTP_REQUEST_TIMEOUT = 30000;
+    static const bool DEFAULT_HTTP_HEDGING = true;
+    static const int DEFAULT_HTTP_MAX_RETRIES = 3;
+    static const int DEFAULT_HTTP_CIRCUIT_FAILURE_THRESHOLD = 5;
+    static const int DEFAULT_HTTP_CIRCUIT_COOLDOWN = 30000;
     static const int DEFAULT_MAX_THREADS_IN_MEMORY = 300;
     static const int DEFAULT_MAX_THREADS_PERSISTED = 200;
     static const QString DEFAULT_LANGUAGE;
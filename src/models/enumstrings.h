@@ -0,0 +1,173 @@
+#ifndef ENUMSTRINGS_H
+#define ENUMSTRINGS_H
+
+#include <QString>
+#include <QStringView>
+#include <QByteArrayView>
+#include <QLatin1String>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace Bytedesk {
+
+// 枚举名称：同一个名称的Latin-1和UTF-16两种静态形式
+template <typename Enum>
+struct EnumName {
+    std::string_view latin1;
+    std::u16string_view utf16;
+    Enum value;
+};
+
+// 由枚举成员名生成 EnumName，例如 BYTEDESK_ENUM_NAME(MessageType, TEXT)
+#define BYTEDESK_ENUM_NAME(Enum, Name) ::Bytedesk::EnumName<Enum>{#Name, u"" #Name, Enum::Name}
+
+// 枚举与字符串互转表
+// 构造时（编译期）搜索一个种子，使 (长度, 首字符, 中间字符, 末字符) 的哈希在所有名称间无冲突，
+// 查找时只计算一次哈希并比较一个候选，不分配内存；UTF-8字节和UTF-16都可直接查找。
+// 转字符串返回静态数据：QLatin1String 或 QString::fromRawData，同样不分配内存
+template <typename Enum, std::size_t N>
+class EnumStringTable
+{
+public:
+    constexpr EnumStringTable(const std::array<EnumName<Enum>, N>& names, Enum fallback)
+        : m_names(names)
+        , m_slots()
+        , m_seed(0)
+        , m_fallback(fallback)
+    {
+        for (std::uint32_t seed = 0; seed < MAX_SEED; ++seed) {
+            if (tryBuild(seed)) {
+                m_seed = seed;
+                return;
+            }
+        }
+        // 只在编译期求值，找不到无冲突的种子时编译失败
+        throw "EnumStringTable: no perfect hash seed found";
+    }
+
+    constexpr Enum fromLatin1(std::string_view text) const {
+        const int index = find(text.data(), text.size());
+        return index >= 0 ? m_names[static_cast<std::size_t>(index)].value : m_fallback;
+    }
+
+    Enum fromUtf8(QByteArrayView text) const {
+        return fromLatin1(std::string_view(text.data(), static_cast<std::size_t>(text.size())));
+    }
+
+    Enum fromString(QStringView text) const {
+        const int index = find(text.utf16(), static_cast<std::size_t>(text.size()));
+        return index >= 0 ? m_names[static_cast<std::size_t>(index)].value : m_fallback;
+    }
+
+    constexpr const EnumName<Enum>& entry(Enum value) const {
+        for (const EnumName<Enum>& name : m_names) {
+            if (name.value == value) {
+                return name;
+            }
+        }
+        return value == m_fallback ? m_names[0] : entry(m_fallback);
+    }
+
+    constexpr std::string_view name(Enum value) const { return entry(value).latin1; }
+
+    static constexpr std::size_t size() { return N; }
+
+    // 每个名称都能查回自身的枚举值、枚举值能查回该名称，且两种形式等长；供 static_assert 使用
+    constexpr bool isConsistent() const {
+        for (const EnumName<Enum>& name : m_names) {
+            if (fromLatin1(name.latin1) != name.value || entry(name.value).latin1 != name.latin1
+                || name.utf16.size() != name.latin1.size()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    QLatin1String latin1(Enum value) const {
+        const std::string_view text = entry(value).latin1;
+        return QLatin1String(text.data(), static_cast<qsizetype>(text.size()));
+    }
+
+    QString toString(Enum value) const {
+        const std::u16string_view text = entry(value).utf16;
+        return QString::fromRawData(reinterpret_cast<const QChar*>(text.data()),
+                                    static_cast<qsizetype>(text.size()));
+    }
+
+private:
+    // 不小于 2N 的2的幂，装载因子不超过一半，容易找到无冲突的种子
+    static constexpr std::size_t slotCount() {
+        std::size_t slots = 1;
+        while (slots < N * 2) {
+            slots <<= 1;
+        }
+        return slots;
+    }
+
+    static constexpr std::size_t SLOTS = slotCount();
+    static constexpr std::uint32_t MAX_SEED = 4096;
+
+    template <typename Char>
+    static constexpr std::size_t hash(const Char* data, std::size_t size, std::uint32_t seed) {
+        std::uint32_t h = (seed * 0x9E3779B1u) ^ static_cast<std::uint32_t>(size);
+        h = (h ^ static_cast<std::uint32_t>(data[0])) * 16777619u;
+        h = (h ^ static_cast<std::uint32_t>(data[size / 2])) * 16777619u;
+        h = (h ^ static_cast<std::uint32_t>(data[size - 1])) * 16777619u;
+        h ^= h >> 15;
+        return static_cast<std::size_t>(h) & (SLOTS - 1);
+    }
+
+    constexpr bool tryBuild(std::uint32_t seed) {
+        for (std::size_t slot = 0; slot < SLOTS; ++slot) {
+            m_slots[slot] = -1;
+        }
+        for (std::size_t i = 0; i < N; ++i) {
+            const std::string_view text = m_names[i].latin1;
+            const std::size_t slot = hash(text.data(), text.size(), seed);
+            if (m_slots[slot] >= 0) {
+                return false;
+            }
+            m_slots[slot] = static_cast<int>(i);
+        }
+        return true;
+    }
+
+    template <typename Char>
+    constexpr int find(const Char* data, std::size_t size) const {
+        if (size == 0) {
+            return -1;
+        }
+        const int index = m_slots[hash(data, size, m_seed)];
+        if (index < 0) {
+            return -1;
+        }
+        const std::string_view candidate = m_names[static_cast<std::size_t>(index)].latin1;
+        if (candidate.size() != size) {
+            return -1;
+        }
+        for (std::size_t i = 0; i < size; ++i) {
+            if (static_cast<std::uint32_t>(data[i]) != static_cast<unsigned char>(candidate[i])) {
+                return -1;
+            }
+        }
+        return index;
+    }
+
+    std::array<EnumName<Enum>, N> m_names;
+    std::array<int, SLOTS> m_slots;
+    std::uint32_t m_seed;
+    Enum m_fallback;
+};
+
+// 由名称列表构造互转表，名称数量自动推导
+template <typename Enum, typename... Names>
+constexpr EnumStringTable<Enum, sizeof...(Names)> makeEnumStringTable(Enum fallback, Names... names)
+{
+    return EnumStringTable<Enum, sizeof...(Names)>({{names...}}, fallback);
+}
+
+} // namespace Bytedesk
+
+#endif // ENUMSTRINGS_H
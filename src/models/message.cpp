@@ -1,9 +1,48 @@
 #include "message.h"
-#include <QUuid>
+#include "enumstrings.h"
+#include "uidgenerator.h"
 #include <QJsonArray>
 
 namespace Bytedesk {
 
+namespace {
+
+// 枚举字符串表，编译期生成完美哈希
+constexpr auto MESSAGE_TYPE_NAMES = makeEnumStringTable(
+    MessageType::TEXT,
+    BYTEDESK_ENUM_NAME(MessageType, TEXT),
+    BYTEDESK_ENUM_NAME(MessageType, IMAGE),
+    BYTEDESK_ENUM_NAME(MessageType, FILE),
+    BYTEDESK_ENUM_NAME(MessageType, VIDEO),
+    BYTEDESK_ENUM_NAME(MessageType, VOICE),
+    BYTEDESK_ENUM_NAME(MessageType, TYPING),
+    BYTEDESK_ENUM_NAME(MessageType, NOTICE),
+    BYTEDESK_ENUM_NAME(MessageType, RECALL),
+    BYTEDESK_ENUM_NAME(MessageType, DELIVERED),
+    BYTEDESK_ENUM_NAME(MessageType, READ),
+    BYTEDESK_ENUM_NAME(MessageType, CUSTOM));
+
+constexpr auto MESSAGE_STATUS_NAMES = makeEnumStringTable(
+    MessageStatus::SENDING,
+    BYTEDESK_ENUM_NAME(MessageStatus, SENDING),
+    BYTEDESK_ENUM_NAME(MessageStatus, SENT),
+    BYTEDESK_ENUM_NAME(MessageStatus, DELIVERED),
+    BYTEDESK_ENUM_NAME(MessageStatus, READ),
+    BYTEDESK_ENUM_NAME(MessageStatus, FAILED),
+    BYTEDESK_ENUM_NAME(MessageStatus, RECALLED));
+
+// 编译期校验：名称与枚举值一一对应、覆盖全部成员，未知名称回退到默认值
+static_assert(MESSAGE_TYPE_NAMES.isConsistent(), "MessageType names are inconsistent");
+static_assert(MESSAGE_TYPE_NAMES.size() == static_cast<std::size_t>(MessageType::CUSTOM) + 1,
+              "MessageType member missing from MESSAGE_TYPE_NAMES");
+static_assert(MESSAGE_TYPE_NAMES.fromLatin1("UNKNOWN") == MessageType::TEXT, "MessageType fallback");
+static_assert(MESSAGE_STATUS_NAMES.isConsistent(), "MessageStatus names are inconsistent");
+static_assert(MESSAGE_STATUS_NAMES.size() == static_cast<std::size_t>(MessageStatus::RECALLED) + 1,
+              "MessageStatus member missing from MESSAGE_STATUS_NAMES");
+static_assert(MESSAGE_STATUS_NAMES.fromLatin1("UNKNOWN") == MessageStatus::SENDING, "MessageStatus fallback");
+
+} // namespace
+
 Message::Message()
     : m_createdAt(QDateTime::currentDateTime())
 {
@@ -25,9 +64,56 @@ QString Message::getStatusString() const
     return statusToString(m_status);
 }
 
+const MessageContent& Message::getContent() const
+{
+    ensureContentDecoded();
+    return m_content;
+}
+
 QString Message::getContentString() const
 {
-    return m_content.toString();
+    if (isSystemMessage()) {
+        return getContentText();
+    }
+
+    if (!m_hasRawContent || !rawContentIsJson()) {
+        // 结构化内容或纯文本：生成一次JSON形式并缓存
+        ensureContentDecoded();
+        m_rawContent = QJsonDocument(m_content.toJson()).toJson(QJsonDocument::Compact);
+        m_hasRawContent = true;
+    }
+    return QString::fromUtf8(m_rawContent);
+}
+
+QString Message::getContentText() const
+{
+    // 纯文本直接转换，不需要解析
+    if (m_hasRawContent && (isSystemMessage() || !rawContentIsJson())) {
+        return QString::fromUtf8(m_rawContent);
+    }
+    ensureContentDecoded();
+    return m_content.text;
+}
+
+void Message::ensureContentDecoded() const
+{
+    if (m_contentDecoded) {
+        return;
+    }
+    m_contentDecoded = true;
+    m_content = MessageContent();
+
+    if (!isSystemMessage() && rawContentIsJson()) {
+        QJsonParseError error;
+        QJsonDocument doc = QJsonDocument::fromJson(m_rawContent, &error);
+        if (error.error == QJsonParseError::NoError && doc.isObject()) {
+            m_content = MessageContent::fromJson(doc.object());
+            return;
+        }
+    }
+
+    // 纯文本
+    m_content.text = QString::fromUtf8(m_rawContent);
 }
 
 void Message::setType(const QString& typeStr)
@@ -40,16 +126,48 @@ void Message::setStatus(const QString& statusStr)
     m_status = stringToStatus(statusStr);
 }
 
+void Message::setTypeUtf8(QByteArrayView typeStr)
+{
+    m_type = MESSAGE_TYPE_NAMES.fromUtf8(typeStr);
+}
+
+void Message::setStatusUtf8(QByteArrayView statusStr)
+{
+    m_status = MESSAGE_STATUS_NAMES.fromUtf8(statusStr);
+}
+
+void Message::setContent(const MessageContent& content)
+{
+    m_content = content;
+    m_contentDecoded = true;
+    m_rawContent.clear();
+    m_hasRawContent = false;
+}
+
 void Message::setContent(const QString& contentStr)
 {
-    QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson(contentStr.toUtf8(), &error);
-    if (error.error == QJsonParseError::NoError && doc.isObject()) {
-        m_content = MessageContent::fromJson(doc.object());
-    } else {
-        // 纯文本
-        m_content.text = contentStr;
-    }
+    m_rawContent = contentStr.toUtf8();
+    m_hasRawContent = true;
+    m_contentDecoded = false;
+}
+
+void Message::setContent(const QJsonObject& contentJson)
+{
+    setContent(MessageContent::fromJson(contentJson));
+}
+
+void Message::setContentUtf8(QByteArrayView utf8)
+{
+    m_rawContent = utf8.toByteArray();
+    m_hasRawContent = true;
+    m_contentDecoded = false;
+}
+
+void Message::setExtra(const QJsonObject& extra)
+{
+    m_extraJson = extra;
+    m_hasExtraJson = true;
+    m_extra = QString::fromUtf8(QJsonDocument(extra).toJson(QJsonDocument::Compact));
 }
 
 QJsonObject Message::toJson() const
@@ -58,13 +176,23 @@ QJsonObject Message::toJson() const
     obj["uid"] = m_uid;
     obj["type"] = getTypeString();
     obj["status"] = getStatusString();
-    obj["content"] = m_content.toJson();
+    if (isSystemMessage()) {
+        // 保持与结构化内容相同的对象形式，纯文本放在 text 字段
+        QJsonObject content;
+        content["text"] = getContentText();
+        obj["content"] = content;
+    } else {
+        obj["content"] = getContent().toJson();
+    }
     obj["createdAt"] = m_createdAt.toString(Qt::ISODate);
     obj["threadUid"] = m_threadUid;
     obj["userUid"] = m_userUid;
     obj["userName"] = m_userName;
     obj["userAvatar"] = m_userAvatar;
-    if (!m_extra.isEmpty()) {
+    if (m_hasExtraJson) {
+        obj["extra"] = m_extraJson;
+    } else if (!m_extra.isEmpty()) {
+        // 只有从Protobuf等字符串来源设置的 extra 才需要解析
         obj["extra"] = QJsonDocument::fromJson(m_extra.toUtf8()).object();
     }
     return obj;
@@ -77,8 +205,16 @@ Message Message::fromJson(const QJsonObject& json)
     msg.setType(json["type"].toString());
     msg.setStatus(json["status"].toString());
 
-    if (json.contains("content")) {
-        msg.setContent(json["content"].toObject());
+    const QJsonValue content = json["content"];
+    if (content.isString()) {
+        msg.setContent(content.toString());
+    } else if (content.isObject()) {
+        if (msg.isSystemMessage()) {
+            // 系统消息只取纯文本
+            msg.setContent(content.toObject()["text"].toString());
+        } else {
+            msg.setContent(content.toObject());
+        }
     }
 
     msg.setCreatedAt(QDateTime::fromString(json["createdAt"].toString(), Qt::ISODate));
@@ -88,7 +224,7 @@ Message Message::fromJson(const QJsonObject& json)
     msg.setUserAvatar(json["userAvatar"].toString());
 
     if (json.contains("extra")) {
-        msg.setExtra(QJsonDocument(json["extra"].toObject()).toJson(QJsonDocument::Compact));
+        msg.setExtra(json["extra"].toObject());
     }
 
     return msg;
@@ -96,69 +232,37 @@ Message Message::fromJson(const QJsonObject& json)
 
 QString Message::generateUid()
 {
-    return QUuid::createUuid().toString(QUuid::WithoutBraces);
+    return UidGenerator::createString();
 }
 
-MessageType Message::stringToType(const QString& typeStr)
+MessageType Message::stringToType(QStringView typeStr)
 {
-    static QHash<QString, MessageType> typeMap = {
-        {"TEXT", MessageType::TEXT},
-        {"IMAGE", MessageType::IMAGE},
-        {"FILE", MessageType::FILE},
-        {"VIDEO", MessageType::VIDEO},
-        {"VOICE", MessageType::VOICE},
-        {"TYPING", MessageType::TYPING},
-        {"NOTICE", MessageType::NOTICE},
-        {"RECALL", MessageType::RECALL},
-        {"DELIVERED", MessageType::DELIVERED},
-        {"READ", MessageType::READ},
-        {"CUSTOM", MessageType::CUSTOM}
-    };
-    return typeMap.value(typeStr, MessageType::TEXT);
+    return MESSAGE_TYPE_NAMES.fromString(typeStr);
 }
 
 QString Message::typeToString(MessageType type)
 {
-    switch (type) {
-        case MessageType::TEXT: return "TEXT";
-        case MessageType::IMAGE: return "IMAGE";
-        case MessageType::FILE: return "FILE";
-        case MessageType::VIDEO: return "VIDEO";
-        case MessageType::VOICE: return "VOICE";
-        case MessageType::TYPING: return "TYPING";
-        case MessageType::NOTICE: return "NOTICE";
-        case MessageType::RECALL: return "RECALL";
-        case MessageType::DELIVERED: return "DELIVERED";
-        case MessageType::READ: return "READ";
-        case MessageType::CUSTOM: return "CUSTOM";
-        default: return "TEXT";
-    }
+    return MESSAGE_TYPE_NAMES.toString(type);
 }
 
-MessageStatus Message::stringToStatus(const QString& statusStr)
+QLatin1String Message::typeName(MessageType type)
 {
-    static QHash<QString, MessageStatus> statusMap = {
-        {"SENDING", MessageStatus::SENDING},
-        {"SENT", MessageStatus::SENT},
-        {"DELIVERED", MessageStatus::DELIVERED},
-        {"READ", MessageStatus::READ},
-        {"FAILED", MessageStatus::FAILED},
-        {"RECALLED", MessageStatus::RECALLED}
-    };
-    return statusMap.value(statusStr, MessageStatus::SENDING);
+    return MESSAGE_TYPE_NAMES.latin1(type);
+}
+
+MessageStatus Message::stringToStatus(QStringView statusStr)
+{
+    return MESSAGE_STATUS_NAMES.fromString(statusStr);
 }
 
 QString Message::statusToString(MessageStatus status)
 {
-    switch (status) {
-        case MessageStatus::SENDING: return "SENDING";
-        case MessageStatus::SENT: return "SENT";
-        case MessageStatus::DELIVERED: return "DELIVERED";
-        case MessageStatus::READ: return "READ";
-        case MessageStatus::FAILED: return "FAILED";
-        case MessageStatus::RECALLED: return "RECALLED";
-        default: return "SENDING";
-    }
+    return MESSAGE_STATUS_NAMES.toString(status);
+}
+
+QLatin1String Message::statusName(MessageStatus status)
+{
+    return MESSAGE_STATUS_NAMES.latin1(status);
 }
 
 } // namespace Bytedesk
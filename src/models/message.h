@@ -6,6 +6,8 @@
 #include <QSharedPointer>
 #include <QJsonObject>
 #include <QJsonDocument>
+#include <QByteArrayView>
+#include <QStringView>
 
 namespace Bytedesk {
 
@@ -77,6 +79,9 @@ struct MessageContent {
 };
 
 // 消息模型
+// 内容按原始UTF-8保存，读取 MessageContent 字段时才解码并缓存；
+// 系统消息（回执、正在输入、通知等）的内容是纯文本，从不经过JSON解析。
+// 缓存在const方法中填充，同一对象不要在多个线程中同时读取
 class Message
 {
 public:
@@ -89,8 +94,11 @@ public:
     QString getTypeString() const;
     MessageStatus getStatus() const { return m_status; }
     QString getStatusString() const;
-    MessageContent getContent() const { return m_content; }
+    const MessageContent& getContent() const;
+    // 非系统消息返回JSON形式，系统消息返回纯文本
     QString getContentString() const;
+    // 文本内容：纯文本直接返回，不解析
+    QString getContentText() const;
     QDateTime getCreatedAt() const { return m_createdAt; }
     QString getThreadUid() const { return m_threadUid; }
     QString getUserUid() const { return m_userUid; }
@@ -104,15 +112,23 @@ public:
     void setType(const QString& typeStr);
     void setStatus(MessageStatus status) { m_status = status; }
     void setStatus(const QString& statusStr);
-    void setContent(const MessageContent& content) { m_content = content; }
+    // 直接从UTF-8字节解析（如protobuf字段），省去 QString 转换
+    void setTypeUtf8(QByteArrayView typeStr);
+    void setStatusUtf8(QByteArrayView statusStr);
+    void setContent(const MessageContent& content);
+    // JSON对象或纯文本，延迟到读取字段时解码
     void setContent(const QString& contentStr);
-    void setContent(const QJsonObject& contentJson) { m_content = MessageContent::fromJson(contentJson); }
+    void setContent(const QJsonObject& contentJson);
+    // 直接从UTF-8字节设置内容，省去 QString 与 UTF-8 之间的往返转换
+    void setContentUtf8(QByteArrayView utf8);
     void setCreatedAt(const QDateTime& time) { m_createdAt = time; }
     void setThreadUid(const QString& uid) { m_threadUid = uid; }
     void setUserUid(const QString& uid) { m_userUid = uid; }
     void setUserName(const QString& name) { m_userName = name; }
     void setUserAvatar(const QString& avatar) { m_userAvatar = avatar; }
-    void setExtra(const QString& extra) { m_extra = extra; }
+    void setExtra(const QString& extra) { m_extra = extra; m_extraJson = QJsonObject(); m_hasExtraJson = false; }
+    // 同时保留对象形式，toJson() 直接输出，不再解析字符串
+    void setExtra(const QJsonObject& extra);
 
     // 序列化
     QJsonObject toJson() const;
@@ -137,23 +153,36 @@ public:
     }
 
     // 静态工具方法
+    // 按时间排序的UUIDv7，见 UidGenerator
     static QString generateUid();
-    static MessageType stringToType(const QString& typeStr);
+    static MessageType stringToType(QStringView typeStr);
     static QString typeToString(MessageType type);
-    static MessageStatus stringToStatus(const QString& statusStr);
+    static MessageStatus stringToStatus(QStringView statusStr);
     static QString statusToString(MessageStatus status);
+    // 返回静态数据，不分配内存
+    static QLatin1String typeName(MessageType type);
+    static QLatin1String statusName(MessageStatus status);
 
 private:
     QString m_uid;
     MessageType m_type = MessageType::TEXT;
     MessageStatus m_status = MessageStatus::SENDING;
-    MessageContent m_content;
+
+    void ensureContentDecoded() const;
+    bool rawContentIsJson() const { return !m_rawContent.isEmpty() && m_rawContent.front() == '{'; }
+
+    mutable QByteArray m_rawContent;        // 原始内容（JSON对象或纯文本）
+    mutable MessageContent m_content;       // 解码后的内容
+    mutable bool m_hasRawContent = false;
+    mutable bool m_contentDecoded = true;
     QDateTime m_createdAt;
     QString m_threadUid;
     QString m_userUid;
     QString m_userName;
     QString m_userAvatar;
     QString m_extra;
+    QJsonObject m_extraJson;                // setExtra(QJsonObject) 设置时有效
+    bool m_hasExtraJson = false;
 };
 
 // 使用智能指针的消息类型
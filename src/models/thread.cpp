@@ -1,7 +1,37 @@
 #include "thread.h"
+#include "enumstrings.h"
 
 namespace Bytedesk {
 
+namespace {
+
+// 枚举字符串表，编译期生成完美哈希
+constexpr auto THREAD_TYPE_NAMES = makeEnumStringTable(
+    ThreadType::UNKNOWN,
+    BYTEDESK_ENUM_NAME(ThreadType, AGENT),
+    BYTEDESK_ENUM_NAME(ThreadType, WORKGROUP),
+    BYTEDESK_ENUM_NAME(ThreadType, ROBOT),
+    BYTEDESK_ENUM_NAME(ThreadType, GROUP),
+    BYTEDESK_ENUM_NAME(ThreadType, MEMBER),
+    BYTEDESK_ENUM_NAME(ThreadType, UNKNOWN));
+
+constexpr auto THREAD_STATUS_NAMES = makeEnumStringTable(
+    ThreadStatus::UNKNOWN,
+    BYTEDESK_ENUM_NAME(ThreadStatus, QUEUEING),
+    BYTEDESK_ENUM_NAME(ThreadStatus, SERVICING),
+    BYTEDESK_ENUM_NAME(ThreadStatus, CLOSED),
+    BYTEDESK_ENUM_NAME(ThreadStatus, UNKNOWN));
+
+// 编译期校验：名称与枚举值一一对应、覆盖全部成员，未知名称回退到 UNKNOWN
+static_assert(THREAD_TYPE_NAMES.isConsistent(), "ThreadType names are inconsistent");
+static_assert(THREAD_TYPE_NAMES.size() == 6, "ThreadType member missing from THREAD_TYPE_NAMES");
+static_assert(THREAD_TYPE_NAMES.fromLatin1("VISITOR") == ThreadType::UNKNOWN, "ThreadType fallback");
+static_assert(THREAD_STATUS_NAMES.isConsistent(), "ThreadStatus names are inconsistent");
+static_assert(THREAD_STATUS_NAMES.size() == 4, "ThreadStatus member missing from THREAD_STATUS_NAMES");
+static_assert(THREAD_STATUS_NAMES.fromLatin1("OPEN") == ThreadStatus::UNKNOWN, "ThreadStatus fallback");
+
+} // namespace
+
 Thread::Thread()
     : m_updatedAt(QDateTime::currentDateTime())
 {
@@ -33,6 +63,16 @@ void Thread::setStatus(const QString& statusStr)
     m_status = stringToStatus(statusStr);
 }
 
+void Thread::setTypeUtf8(QByteArrayView typeStr)
+{
+    m_type = THREAD_TYPE_NAMES.fromUtf8(typeStr);
+}
+
+void Thread::setStatusUtf8(QByteArrayView statusStr)
+{
+    m_status = THREAD_STATUS_NAMES.fromUtf8(statusStr);
+}
+
 QJsonObject Thread::toJson() const
 {
     QJsonObject obj;
@@ -97,48 +137,34 @@ void Thread::updateLastMessage(const MessagePtr& msg)
     m_updatedAt = msg->getCreatedAt();
 }
 
-ThreadType Thread::stringToType(const QString& typeStr)
+ThreadType Thread::stringToType(QStringView typeStr)
 {
-    static QHash<QString, ThreadType> typeMap = {
-        {"AGENT", ThreadType::AGENT},
-        {"WORKGROUP", ThreadType::WORKGROUP},
-        {"ROBOT", ThreadType::ROBOT},
-        {"GROUP", ThreadType::GROUP},
-        {"MEMBER", ThreadType::MEMBER}
-    };
-    return typeMap.value(typeStr, ThreadType::UNKNOWN);
+    return THREAD_TYPE_NAMES.fromString(typeStr);
 }
 
 QString Thread::typeToString(ThreadType type)
 {
-    switch (type) {
-        case ThreadType::AGENT: return "AGENT";
-        case ThreadType::WORKGROUP: return "WORKGROUP";
-        case ThreadType::ROBOT: return "ROBOT";
-        case ThreadType::GROUP: return "GROUP";
-        case ThreadType::MEMBER: return "MEMBER";
-        default: return "UNKNOWN";
-    }
+    return THREAD_TYPE_NAMES.toString(type);
 }
 
-ThreadStatus Thread::stringToStatus(const QString& statusStr)
+QLatin1String Thread::typeName(ThreadType type)
 {
-    static QHash<QString, ThreadStatus> statusMap = {
-        {"QUEUEING", ThreadStatus::QUEUEING},
-        {"SERVICING", ThreadStatus::SERVICING},
-        {"CLOSED", ThreadStatus::CLOSED}
-    };
-    return statusMap.value(statusStr, ThreadStatus::UNKNOWN);
+    return THREAD_TYPE_NAMES.latin1(type);
+}
+
+ThreadStatus Thread::stringToStatus(QStringView statusStr)
+{
+    return THREAD_STATUS_NAMES.fromString(statusStr);
 }
 
 QString Thread::statusToString(ThreadStatus status)
 {
-    switch (status) {
-        case ThreadStatus::QUEUEING: return "QUEUEING";
-        case ThreadStatus::SERVICING: return "SERVICING";
-        case ThreadStatus::CLOSED: return "CLOSED";
-        default: return "UNKNOWN";
-    }
+    return THREAD_STATUS_NAMES.toString(status);
+}
+
+QLatin1String Thread::statusName(ThreadStatus status)
+{
+    return THREAD_STATUS_NAMES.latin1(status);
 }
 
 } // namespace Bytedesk
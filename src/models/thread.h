@@ -59,6 +59,9 @@ public:
     void setType(const QString& typeStr);
     void setStatus(ThreadStatus status) { m_status = status; }
     void setStatus(const QString& statusStr);
+    // 直接从UTF-8字节解析（如protobuf字段），省去 QString 转换
+    void setTypeUtf8(QByteArrayView typeStr);
+    void setStatusUtf8(QByteArrayView statusStr);
     void setTopic(const QString& topic) { m_topic = topic; }
     void setTitle(const QString& title) { m_title = title; }
     void setAvatar(const QString& avatar) { m_avatar = avatar; }
@@ -88,10 +91,13 @@ public:
     void updateLastMessage(const MessagePtr& msg);
 
     // 静态工具方法
-    static ThreadType stringToType(const QString& typeStr);
+    static ThreadType stringToType(QStringView typeStr);
     static QString typeToString(ThreadType type);
-    static ThreadStatus stringToStatus(const QString& statusStr);
+    static ThreadStatus stringToStatus(QStringView statusStr);
     static QString statusToString(ThreadStatus status);
+    // 返回静态数据，不分配内存
+    static QLatin1String typeName(ThreadType type);
+    static QLatin1String statusName(ThreadStatus status);
 
 private:
     QString m_uid;
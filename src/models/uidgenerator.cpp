@@ -0,0 +1,86 @@
+#include "uidgenerator.h"
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <array>
+#include <atomic>
+
+namespace Bytedesk {
+
+namespace {
+
+const int COUNTER_BITS = 12;
+const quint64 COUNTER_MASK = (quint64(1) << COUNTER_BITS) - 1;
+
+// 最近一次分配的 (毫秒 << 12) | 计数
+std::atomic<quint64> g_lastTick{0};
+
+// 每线程的熵缓冲，用完后整批重新填充
+struct EntropyBuffer {
+    std::array<quint64, 64> words;
+    size_t next = words.size();
+
+    quint64 take() {
+        if (next == words.size()) {
+            QRandomGenerator::system()->fillRange(words.data(), static_cast<qsizetype>(words.size()));
+            next = 0;
+        }
+        return words[next++];
+    }
+};
+
+thread_local EntropyBuffer t_entropy;
+
+quint64 nextTick()
+{
+    const quint64 now = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch()) << COUNTER_BITS;
+
+    quint64 last = g_lastTick.load(std::memory_order_relaxed);
+    quint64 next;
+    do {
+        // 新的一毫秒从0计数；同一毫秒内（或时钟回拨时）在上一个值上加一
+        next = now > last ? now : last + 1;
+    } while (!g_lastTick.compare_exchange_weak(last, next, std::memory_order_relaxed));
+
+    return next;
+}
+
+} // namespace
+
+QUuid UidGenerator::create()
+{
+    const quint64 tick = nextTick();
+    const quint64 ms = tick >> COUNTER_BITS;
+    const quint64 random = t_entropy.take();
+
+    return QUuid(static_cast<uint>(ms >> 16),
+                 static_cast<ushort>(ms & 0xFFFF),
+                 static_cast<ushort>(0x7000 | (tick & COUNTER_MASK)),
+                 static_cast<uchar>(0x80 | ((random >> 56) & 0x3F)),
+                 static_cast<uchar>(random >> 48),
+                 static_cast<uchar>(random >> 40),
+                 static_cast<uchar>(random >> 32),
+                 static_cast<uchar>(random >> 24),
+                 static_cast<uchar>(random >> 16),
+                 static_cast<uchar>(random >> 8),
+                 static_cast<uchar>(random));
+}
+
+QString UidGenerator::createString()
+{
+    return create().toString(QUuid::WithoutBraces);
+}
+
+QByteArray UidGenerator::createBinary()
+{
+    return create().toRfc4122();
+}
+
+qint64 UidGenerator::timestampMs(const QUuid& uid)
+{
+    if ((uid.data3 >> 12) != 7) {
+        return -1;
+    }
+    return (static_cast<qint64>(uid.data1) << 16) | uid.data2;
+}
+
+} // namespace Bytedesk
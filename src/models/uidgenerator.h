@@ -0,0 +1,32 @@
+#ifndef UIDGENERATOR_H
+#define UIDGENERATOR_H
+
+#include <QUuid>
+#include <QString>
+#include <QByteArray>
+
+namespace Bytedesk {
+
+// 按时间排序的UID生成器（UUIDv7，RFC 9562）
+// 布局：48位Unix毫秒时间戳 | 版本7 | 12位单调计数 | 变体 | 62位随机数。
+// 时间戳和计数合成一个原子值，用CAS递增，跨线程单调且无锁；
+// 同一毫秒内计数溢出时时间戳顺延一毫秒。随机数取自每线程的熵缓冲，批量从系统随机源填充。
+// 16字节二进制形式（RFC 4122字节序）按字节比较即按时间排序，可直接作为本地存储的键
+class UidGenerator
+{
+public:
+    static QUuid create();
+
+    // 36字符字符串形式，不带花括号
+    static QString createString();
+
+    // 16字节二进制形式
+    static QByteArray createBinary();
+
+    // 从UUIDv7中取出毫秒时间戳；非v7返回-1
+    static qint64 timestampMs(const QUuid& uid);
+};
+
+} // namespace Bytedesk
+
+#endif // UIDGENERATOR_H
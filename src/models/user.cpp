@@ -1,7 +1,39 @@
 #include "user.h"
+#include "enumstrings.h"
 
 namespace Bytedesk {
 
+namespace {
+
+// 枚举字符串表，编译期生成完美哈希
+constexpr auto USER_TYPE_NAMES = makeEnumStringTable(
+    UserType::USER,
+    BYTEDESK_ENUM_NAME(UserType, AGENT),
+    BYTEDESK_ENUM_NAME(UserType, USER),
+    BYTEDESK_ENUM_NAME(UserType, MEMBER),
+    BYTEDESK_ENUM_NAME(UserType, ROBOT),
+    BYTEDESK_ENUM_NAME(UserType, SYSTEM));
+
+constexpr auto USER_STATUS_NAMES = makeEnumStringTable(
+    UserStatus::OFFLINE,
+    BYTEDESK_ENUM_NAME(UserStatus, ONLINE),
+    BYTEDESK_ENUM_NAME(UserStatus, OFFLINE),
+    BYTEDESK_ENUM_NAME(UserStatus, BUSY),
+    BYTEDESK_ENUM_NAME(UserStatus, AWAY),
+    BYTEDESK_ENUM_NAME(UserStatus, INVISIBLE));
+
+// 编译期校验：名称与枚举值一一对应、覆盖全部成员，未知名称回退到默认值
+static_assert(USER_TYPE_NAMES.isConsistent(), "UserType names are inconsistent");
+static_assert(USER_TYPE_NAMES.size() == static_cast<std::size_t>(UserType::SYSTEM) + 1,
+              "UserType member missing from USER_TYPE_NAMES");
+static_assert(USER_TYPE_NAMES.fromLatin1("VISITOR") == UserType::USER, "UserType fallback");
+static_assert(USER_STATUS_NAMES.isConsistent(), "UserStatus names are inconsistent");
+static_assert(USER_STATUS_NAMES.size() == static_cast<std::size_t>(UserStatus::INVISIBLE) + 1,
+              "UserStatus member missing from USER_STATUS_NAMES");
+static_assert(USER_STATUS_NAMES.fromLatin1("IDLE") == UserStatus::OFFLINE, "UserStatus fallback");
+
+} // namespace
+
 User::User()
     : m_createdAt(QDateTime::currentDateTime())
 {
@@ -33,6 +65,16 @@ void User::setStatus(const QString& statusStr)
     m_status = stringToStatus(statusStr);
 }
 
+void User::setTypeUtf8(QByteArrayView typeStr)
+{
+    m_type = USER_TYPE_NAMES.fromUtf8(typeStr);
+}
+
+void User::setStatusUtf8(QByteArrayView statusStr)
+{
+    m_status = USER_STATUS_NAMES.fromUtf8(statusStr);
+}
+
 QJsonObject User::toJson() const
 {
     QJsonObject obj;
@@ -89,52 +131,34 @@ User User::fromJson(const QJsonObject& json)
     return user;
 }
 
-UserType User::stringToType(const QString& typeStr)
+UserType User::stringToType(QStringView typeStr)
 {
-    static QHash<QString, UserType> typeMap = {
-        {"AGENT", UserType::AGENT},
-        {"USER", UserType::USER},
-        {"MEMBER", UserType::MEMBER},
-        {"ROBOT", UserType::ROBOT},
-        {"SYSTEM", UserType::SYSTEM}
-    };
-    return typeMap.value(typeStr, UserType::USER);
+    return USER_TYPE_NAMES.fromString(typeStr);
 }
 
 QString User::typeToString(UserType type)
 {
-    switch (type) {
-        case UserType::AGENT: return "AGENT";
-        case UserType::USER: return "USER";
-        case UserType::MEMBER: return "MEMBER";
-        case UserType::ROBOT: return "ROBOT";
-        case UserType::SYSTEM: return "SYSTEM";
-        default: return "USER";
-    }
+    return USER_TYPE_NAMES.toString(type);
 }
 
-UserStatus User::stringToStatus(const QString& statusStr)
+QLatin1String User::typeName(UserType type)
 {
-    static QHash<QString, UserStatus> statusMap = {
-        {"ONLINE", UserStatus::ONLINE},
-        {"OFFLINE", UserStatus::OFFLINE},
-        {"BUSY", UserStatus::BUSY},
-        {"AWAY", UserStatus::AWAY},
-        {"INVISIBLE", UserStatus::INVISIBLE}
-    };
-    return statusMap.value(statusStr, UserStatus::OFFLINE);
+    return USER_TYPE_NAMES.latin1(type);
+}
+
+UserStatus User::stringToStatus(QStringView statusStr)
+{
+    return USER_STATUS_NAMES.fromString(statusStr);
 }
 
 QString User::statusToString(UserStatus status)
 {
-    switch (status) {
-        case UserStatus::ONLINE: return "ONLINE";
-        case UserStatus::OFFLINE: return "OFFLINE";
-        case UserStatus::BUSY: return "BUSY";
-        case UserStatus::AWAY: return "AWAY";
-        case UserStatus::INVISIBLE: return "INVISIBLE";
-        default: return "OFFLINE";
-    }
+    return USER_STATUS_NAMES.toString(status);
+}
+
+QLatin1String User::statusName(UserStatus status)
+{
+    return USER_STATUS_NAMES.latin1(status);
 }
 
 } // namespace Bytedesk
@@ -4,6 +4,8 @@
 #include <QString>
 #include <QDateTime>
 #include <QJsonObject>
+#include <QStringView>
+#include <QByteArrayView>
 
 namespace Bytedesk {
 
@@ -55,6 +57,9 @@ public:
     void setType(const QString& typeStr);
     void setStatus(UserStatus status) { m_status = status; }
     void setStatus(const QString& statusStr);
+    // 直接从UTF-8字节解析（如protobuf字段），省去 QString 转换
+    void setTypeUtf8(QByteArrayView typeStr);
+    void setStatusUtf8(QByteArrayView statusStr);
     void setUsername(const QString& username) { m_username = username; }
     void setNickname(const QString& nickname) { m_nickname = nickname; }
     void setAvatar(const QString& avatar) { m_avatar = avatar; }
@@ -94,10 +99,13 @@ public:
     }
 
     // 静态工具方法
-    static UserType stringToType(const QString& typeStr);
+    static UserType stringToType(QStringView typeStr);
     static QString typeToString(UserType type);
-    static UserStatus stringToStatus(const QString& statusStr);
+    static UserStatus stringToStatus(QStringView statusStr);
     static QString statusToString(UserStatus status);
+    // 返回静态数据，不分配内存
+    static QLatin1String typeName(UserType type);
+    static QLatin1String statusName(UserStatus status);
 
 private:
     QString m_uid;
@@ -12,11 +12,14 @@
 #include "core/network/threadapi.h"
 #include "core/mqtt/mqttclient.h"
 #include "core/mqtt/mqttmessagehandler.h"
+#include "core/mqtt/mqttmessagebridge.h"
 #include "core/auth/authmanager.h"
 
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QDateTime>
+#include <QDebug>
+#include <QStandardPaths>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -27,6 +30,8 @@ MainWindow::MainWindow(QWidget *parent)
     , m_threadApi(nullptr)
     , m_mqttClient(nullptr)
     , m_mqttHandler(nullptr)
+    , m_mqttThread(nullptr)
+    , m_mqttBridge(nullptr)
     , m_authManager(nullptr)
     , m_isLoggedIn(false)
 {
@@ -35,14 +40,22 @@ MainWindow::MainWindow(QWidget *parent)
     // 初始化核心组件
     m_httpClient = new HttpClient(this);
     m_httpClient->setBaseUrl(BYTDESK_CONFIG->getApiUrl());
+    m_httpClient->setTimeout(BYTDESK_CONFIG->getHttpRequestTimeout());
+    m_httpClient->setHedgingEnabled(BYTDESK_CONFIG->getHttpHedging());
+    m_httpClient->setRetryPolicy(BYTDESK_CONFIG->getHttpMaxRetries(), 500, 10000);
+    m_httpClient->setCircuitBreaker(BYTDESK_CONFIG->getHttpCircuitFailureThreshold(),
+                                    BYTDESK_CONFIG->getHttpCircuitCooldown());
+    if (BYTDESK_CONFIG->getHttpCacheEnabled()) {
+        m_httpClient->cache()->setMaximumSize(qint64(BYTDESK_CONFIG->getHttpCacheMaxSize()) * 1024 * 1024);
+        m_httpClient->cache()->setDirectory(
+            QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/http");
+    }
 
     m_authApi = new AuthApi(m_httpClient, this);
     m_messageApi = new MessageApi(m_httpClient, this);
     m_threadApi = new ThreadApi(m_httpClient, this);
 
-    m_mqttClient = new MqttClient(this);
-    m_mqttHandler = new MqttMessageHandler(m_mqttClient, this);
-    m_mqttHandler->init();
+    setupMqtt();
 
     m_authManager = new AuthManager(m_authApi, m_mqttClient, this);
 
@@ -53,9 +66,78 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    shutdownMqtt();
     delete ui;
 }
 
+void MainWindow::setupMqtt()
+{
+    const bool useNetworkThread = BYTDESK_CONFIG->getMqttNetworkThread();
+
+    // 网络线程模式下对象不能有父对象，之后整体 moveToThread
+    m_mqttClient = new MqttClient(useNetworkThread ? nullptr : this);
+    m_mqttClient->setKeepAlive(BYTDESK_CONFIG->getMqttKeepAlive());
+    m_mqttClient->setPingTimeout(BYTDESK_CONFIG->getMqttPingTimeout());
+    m_mqttClient->setConnectTimeout(BYTDESK_CONFIG->getMqttConnectTimeout());
+    m_mqttClient->setReconnectInterval(BYTDESK_CONFIG->getMqttReconnectPeriod());
+    m_mqttClient->setMaxReconnectDelay(BYTDESK_CONFIG->getMqttMaxReconnectDelay());
+    m_mqttClient->setCleanSession(BYTDESK_CONFIG->getMqttCleanSession());
+    m_mqttClient->setWriteCoalescing(BYTDESK_CONFIG->getMqttWriteCoalescing(),
+                                     BYTDESK_CONFIG->getMqttWriteBufferSize());
+
+    m_mqttHandler = new MqttMessageHandler(m_mqttClient, useNetworkThread ? nullptr : this);
+    m_mqttHandler->setWireFormat(BYTDESK_CONFIG->getMqttUseProtobuf() ? MqttWireFormat::PROTOBUF
+                                                                     : MqttWireFormat::JSON);
+    m_mqttHandler->setBatchEnvelopeEnabled(BYTDESK_CONFIG->getMqttBatchEnvelope());
+    m_mqttHandler->setDedupCapacity(BYTDESK_CONFIG->getMqttDedupCapacity());
+    m_mqttHandler->setReadWatermarkWindow(BYTDESK_CONFIG->getMqttReadWatermarkWindow());
+    m_mqttHandler->setDecodeParallelism(BYTDESK_CONFIG->getMqttDecodeParallelism());
+    m_mqttHandler->setTypingTimeouts(BYTDESK_CONFIG->getMqttTypingInterval(),
+                                     BYTDESK_CONFIG->getMqttTypingIdleTimeout(),
+                                     BYTDESK_CONFIG->getMqttTypingExpiry());
+    m_mqttHandler->init();
+
+    if (!useNetworkThread) {
+        return;
+    }
+
+    // socket读取、报文解析和消息解码都在网络线程中完成，
+    // 解码后的消息经由无锁队列批量交给UI线程
+    m_mqttThread = new QThread(this);
+    m_mqttThread->setObjectName("MqttNetworkThread");
+
+    m_mqttBridge = new MqttMessageBridge(BYTDESK_CONFIG->getMqttBridgeCapacity(), this);
+    m_mqttHandler->setMessageBridge(m_mqttBridge);
+
+    m_mqttClient->moveToThread(m_mqttThread);
+    m_mqttHandler->moveToThread(m_mqttThread);
+
+    // 线程退出时在网络线程中释放对象
+    connect(m_mqttThread, &QThread::finished, m_mqttHandler, &QObject::deleteLater);
+    connect(m_mqttThread, &QThread::finished, m_mqttClient, &QObject::deleteLater);
+
+    m_mqttThread->start();
+    qDebug() << "MQTT running on network thread";
+}
+
+void MainWindow::shutdownMqtt()
+{
+    if (!m_mqttThread) {
+        return;
+    }
+
+    // 先让生产者停止等待，再在网络线程中同步断开连接，最后结束线程
+    m_mqttBridge->close();
+    QMetaObject::invokeMethod(m_mqttClient, &MqttClient::disconnectFromHost,
+                              Qt::BlockingQueuedConnection);
+    m_mqttThread->quit();
+    m_mqttThread->wait();
+
+    m_mqttThread = nullptr;
+    m_mqttHandler = nullptr;
+    m_mqttClient = nullptr;
+}
+
 void MainWindow::setupConnections()
 {
     // 菜单动作 - Qt 6的triggered信号带bool参数，使用lambda忽略
@@ -70,6 +152,16 @@ void MainWindow::setupConnections()
     connect(ui->threadListWidget, &QListWidget::itemClicked, this, &MainWindow::onThreadItemClicked);
     connect(ui->messageLineEdit, &QLineEdit::returnPressed, this, &MainWindow::onMessageLineEditReturnPressed);
 
+    // 服务端熔断状态
+    connect(m_httpClient, &HttpClient::circuitStateChanged, this,
+            [this](const QString& host, HttpCircuitState state) {
+        if (state == HttpCircuitState::OPEN) {
+            updateStatusBar(QString("服务器 %1 暂时无法访问，稍后自动重试").arg(host));
+        } else if (state == HttpCircuitState::CLOSED) {
+            updateStatusBar(QString("服务器 %1 已恢复").arg(host));
+        }
+    });
+
     // 认证管理器信号
     connect(m_authManager, &AuthManager::loginSuccess, this, &MainWindow::onLoginSuccess);
     connect(m_authManager, &AuthManager::loginFailed, this, &MainWindow::onLoginFailed);
@@ -78,6 +170,8 @@ void MainWindow::setupConnections()
         m_currentUser.reset();
         m_currentThread.reset();
         m_threads.clear();
+        // 缓存中是上一个用户的数据
+        m_httpClient->cache()->clear();
         updateUIForLoginState(false);
         updateStatusBar("已登出");
     });
@@ -88,6 +182,16 @@ void MainWindow::setupConnections()
 
     // 消息信号
     connect(m_mqttHandler, &MqttMessageHandler::messageReceived, this, &MainWindow::onMessageReceived);
+    connect(m_mqttHandler, &MqttMessageHandler::messagesReceived, this, &MainWindow::onMessagesReceived);
+
+    // 已读水位：MQTT发出后再通过REST同步一次
+    connect(m_mqttHandler, &MqttMessageHandler::readWatermarkFlushed, this,
+            [this](const QString& threadUid, const QString& messageUid, const QDateTime& readUpTo) {
+        m_messageApi->markThreadRead(threadUid, messageUid, readUpTo, nullptr);
+    });
+    if (m_mqttBridge) {
+        connect(m_mqttBridge, &MqttMessageBridge::messagesReceived, this, &MainWindow::onMessagesReceived);
+    }
 }
 
 void MainWindow::updateUIForLoginState(bool loggedIn)
@@ -114,7 +218,9 @@ void MainWindow::appendMessageToChat(const MessagePtr& message)
         sender = message->getUserUid();
     }
 
-    QString content = message->getContentString();
+    // 文本消息直接显示文字，其他类型显示内容JSON
+    QString content = message->isTextMessage() ? message->getContentText()
+                                               : message->getContentString();
     QString time = message->getCreatedAt().toString("hh:mm:ss");
 
     QString html;
@@ -348,6 +454,20 @@ void MainWindow::onMessageReceived(const MessagePtr& message)
     updateStatusBar("收到新消息");
 }
 
+void MainWindow::onMessagesReceived(const QList<MessagePtr>& messages)
+{
+    // 批量信封或网络线程批量交付，整批只刷新一次状态栏
+    for (const MessagePtr& message : messages) {
+        if (m_currentThread && message->getThreadUid() == m_currentThread->getUid()) {
+            appendMessageToChat(message);
+        }
+    }
+
+    if (!messages.isEmpty()) {
+        updateStatusBar(QString("收到 %1 条新消息").arg(messages.size()));
+    }
+}
+
 void MainWindow::onMqttConnected()
 {
     updateStatusBar("MQTT已连接");
@@ -5,6 +5,7 @@
 #include <QListWidget>
 #include <QPointer>
 #include <QSharedPointer>
+#include <QThread>
 
 // 包含模型类头文件
 #include "models/message.h"
@@ -23,6 +24,7 @@ namespace Bytedesk {
     class ThreadApi;
     class MqttClient;
     class MqttMessageHandler;
+    class MqttMessageBridge;
     class AuthManager;
 }
 
@@ -54,10 +56,13 @@ private slots:
     void onLoginFailed(const QString& error);
     void onThreadsLoaded(const QList<ThreadPtr>& threads);
     void onMessageReceived(const MessagePtr& message);
+    void onMessagesReceived(const QList<MessagePtr>& messages);
     void onMqttConnected();
     void onMqttDisconnected();
 
 private:
+    void setupMqtt();
+    void shutdownMqtt();
     void setupConnections();
     void updateUIForLoginState(bool loggedIn);
     void appendMessageToChat(const MessagePtr& message);
@@ -74,6 +79,8 @@ private:
     ThreadApi* m_threadApi;
     MqttClient* m_mqttClient;
     MqttMessageHandler* m_mqttHandler;
+    QThread* m_mqttThread;           // 网络线程（未启用时为nullptr）
+    MqttMessageBridge* m_mqttBridge; // 网络线程 -> UI线程消息交接
     AuthManager* m_authManager;
 
     // 数据